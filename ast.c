@@ -0,0 +1,108 @@
+#include<stdlib.h>
+#include<string.h>
+#include<assert.h>
+#include "compiler.h"
+
+// 节点数组和类型表的最小容量
+#define AST_MIN_CAPACITY 64
+#define AST_MIN_DATATYPE_CAPACITY 16
+
+static void* ast_resize(void* data, size_t element_size, uint32_t capacity)
+{
+    data = realloc(data, element_size * capacity);
+    assert(data);
+    return data;
+}
+
+/**
+ * @brief 各个节点数组一起扩容到capacity
+ *
+ * @param ast
+ * @param capacity
+ */
+static void ast_reserve(struct ast* ast, uint32_t capacity)
+{
+    ast->kind = ast_resize(ast->kind, sizeof(*ast->kind), capacity);
+    ast->flags = ast_resize(ast->flags, sizeof(*ast->flags), capacity);
+    ast->op = ast_resize(ast->op, sizeof(*ast->op), capacity);
+    ast->token_index = ast_resize(ast->token_index, sizeof(*ast->token_index), capacity);
+    ast->first_child = ast_resize(ast->first_child, sizeof(*ast->first_child), capacity);
+    ast->next_sibling = ast_resize(ast->next_sibling, sizeof(*ast->next_sibling), capacity);
+    ast->type_id = ast_resize(ast->type_id, sizeof(*ast->type_id), capacity);
+    ast->capacity = capacity;
+}
+
+struct ast* ast_create(uint32_t capacity)
+{
+    struct ast* ast = calloc(1, sizeof(struct ast));
+    ast_reserve(ast, capacity > AST_MIN_CAPACITY ? capacity : AST_MIN_CAPACITY);
+    ast->datatype_capacity = AST_MIN_DATATYPE_CAPACITY;
+    ast->datatypes = ast_resize(NULL, sizeof(struct datatype), ast->datatype_capacity);
+
+    // 0号节点和0号类型保留，编号为0表示没有
+    ast_node(ast, NODE_TYPE_BLANK, 0, NODE_ID_NONE);
+    ast_datatype(ast, DATATYPE_VOID, DATATYPE_ID_NONE);
+    return ast;
+}
+
+void ast_free(struct ast* ast)
+{
+    free(ast->kind);
+    free(ast->flags);
+    free(ast->op);
+    free(ast->token_index);
+    free(ast->first_child);
+    free(ast->next_sibling);
+    free(ast->type_id);
+    free(ast->datatypes);
+    free(ast);
+}
+
+uint32_t ast_node(struct ast* ast, int kind, uint32_t token_index, uint32_t first_child)
+{
+    if(ast->count == ast->capacity){
+        ast_reserve(ast, ast->capacity * 2);
+    }
+
+    uint32_t node = ast->count++;
+    ast->kind[node] = kind;
+    ast->flags[node] = 0;
+    ast->op[node] = OPERATOR_NONE;
+    ast->token_index[node] = token_index;
+    ast->first_child[node] = first_child;
+    ast->next_sibling[node] = NODE_ID_NONE;
+    ast->type_id[node] = DATATYPE_ID_NONE;
+    return node;
+}
+
+uint32_t ast_datatype(struct ast* ast, int type, uint32_t base)
+{
+    if(ast->datatype_count == ast->datatype_capacity){
+        ast->datatype_capacity *= 2;
+        ast->datatypes = ast_resize(ast->datatypes, sizeof(struct datatype), ast->datatype_capacity);
+    }
+
+    uint32_t id = ast->datatype_count++;
+    ast->datatypes[id] = (struct datatype){
+        .type = type,
+        .base = base,
+        .node = NODE_ID_NONE
+    };
+    return id;
+}
+
+uint32_t ast_child_count(struct ast* ast, uint32_t node)
+{
+    uint32_t count = 0;
+    for(uint32_t child = ast->first_child[node]; child != NODE_ID_NONE; child = ast->next_sibling[child]){
+        count++;
+    }
+    return count;
+}
+
+size_t ast_bytes(struct ast* ast)
+{
+    size_t node_bytes = sizeof(*ast->kind) + sizeof(*ast->flags) + sizeof(*ast->op) + sizeof(*ast->token_index) +
+                        sizeof(*ast->first_child) + sizeof(*ast->next_sibling) + sizeof(*ast->type_id);
+    return node_bytes * ast->capacity + sizeof(struct datatype) * ast->datatype_capacity;
+}
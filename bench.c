@@ -0,0 +1,471 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include<unistd.h>
+#include<sys/resource.h>
+#include<sys/wait.h>
+#include "compiler.h"
+#include "helpers/vector.h"
+
+/**
+ * 词法分析和语法分析性能测试，结果以JSON输出到标准输出
+ * 用法：lexer_bench [-s bytes] [-n iterations] [-d depth] [-m elements] file.c ...
+ *   -s 每种合成源文件的大小，默认4MB
+ *   -n 每个输入重复分析的次数，取最快一次，默认5
+ *   -d 括号密集源文件的括号嵌套深度，默认32
+ *   -m vector push微基准的元素个数，默认10000000，0表示跳过微基准
+ * 合成源文件之外，命令行给出的文件也逐一测试；合成源文件的语句包在一个函数中，可以完整地语法分析
+ * 需要以-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc链接以统计分配次数
+ */
+
+struct bench_options
+{
+    size_t bytes;
+    int iterations;
+    int depth;
+    int micro_elements;
+};
+
+/*----------allocation counters-----------*/
+static size_t bench_allocations;
+static size_t bench_allocated_bytes;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    bench_allocations++;
+    bench_allocated_bytes += size;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t nmemb, size_t size)
+{
+    bench_allocations++;
+    bench_allocated_bytes += nmemb * size;
+    return __real_calloc(nmemb, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    bench_allocations++;
+    bench_allocated_bytes += size;
+    return __real_realloc(ptr, size);
+}
+
+static double bench_now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/*----------synthetic sources-----------*/
+// xorshift，固定种子保证每次生成的源文件相同
+static uint32_t bench_random_state = 2463534242u;
+
+static uint32_t bench_random()
+{
+    bench_random_state ^= bench_random_state << 13;
+    bench_random_state ^= bench_random_state >> 17;
+    bench_random_state ^= bench_random_state << 5;
+    return bench_random_state;
+}
+
+static void bench_write_identifier(FILE* fp)
+{
+    static const char* words[] = {"value", "count", "buffer", "index", "token", "process", "node", "next"};
+    fprintf(fp, "%s_%u", words[bench_random() % 8], bench_random() % 1000);
+}
+
+static void bench_write_identifiers(FILE* fp, int depth)
+{
+    // 行生成函数共用一个签名，只有括号密集源文件用到depth
+    (void)depth;
+    static const char* types[] = {"int", "char", "long", "unsigned", "struct tag", "const", "static", "double"};
+    fprintf(fp, "%s ", types[bench_random() % 8]);
+    bench_write_identifier(fp);
+    fprintf(fp, " = ");
+    bench_write_identifier(fp);
+    fprintf(fp, ";\n");
+}
+
+static void bench_write_numbers(FILE* fp, int depth)
+{
+    (void)depth;
+    fprintf(fp, "total = %u + %u * %u - %uL;\n", bench_random(), bench_random() % 100000, bench_random() % 100, bench_random() % 10);
+}
+
+static void bench_write_comments(FILE* fp, int depth)
+{
+    (void)depth;
+    if(bench_random() % 2){
+        fprintf(fp, "// single line comment number %u describing the code below in some detail\n", bench_random());
+        return;
+    }
+    fprintf(fp, "/* block comment %u\n * spanning several lines, with * and / inside\n */\n", bench_random());
+}
+
+static void bench_write_parentheses(FILE* fp, int depth)
+{
+    bench_write_identifier(fp);
+    fprintf(fp, " = ");
+    for(int i = 0; i < depth; i++){
+        fprintf(fp, "(");
+        bench_write_identifier(fp);
+        fprintf(fp, " + ");
+    }
+    fprintf(fp, "%u", bench_random() % 100);
+    for(int i = 0; i < depth; i++){
+        fprintf(fp, ")");
+    }
+    fprintf(fp, ";\n");
+}
+
+// 深缩进加对齐用的空白，空白占大部分字节
+static void bench_write_whitespace(FILE* fp, int depth)
+{
+    (void)depth;
+    fprintf(fp, "%*s", (int)(bench_random() % 64), "");
+    bench_write_identifier(fp);
+    fprintf(fp, "%*s=%*s", (int)(bench_random() % 32) + 1, "", (int)(bench_random() % 32) + 1, "");
+    bench_write_identifier(fp);
+    fprintf(fp, "\t\t\t;%*s\n", (int)(bench_random() % 16), "");
+}
+
+// 不含空白的紧凑表达式，几乎每个字节都开始一个新token
+static void bench_write_dense(FILE* fp, int depth)
+{
+    (void)depth;
+    bench_write_identifier(fp);
+    fprintf(fp, "=a[%u]+b*(c-d)/e%%f<<%u|g&~h^i;", bench_random() % 100, bench_random() % 8);
+    bench_write_identifier(fp);
+    fprintf(fp, "+=*p++;\n");
+}
+
+struct bench_generator
+{
+    const char* name;
+    void (*write_line)(FILE* fp, int depth);
+};
+
+static struct bench_generator bench_generators[] = {
+    {"identifiers", bench_write_identifiers},
+    {"numbers", bench_write_numbers},
+    {"comments", bench_write_comments},
+    {"parentheses", bench_write_parentheses},
+    {"whitespace", bench_write_whitespace},
+    {"dense", bench_write_dense},
+};
+
+/**
+ * @brief 生成约bytes字节的合成源文件
+ *
+ * @return char* 临时文件名，调用者负责删除
+ */
+static char* bench_generate(struct bench_generator* generator, struct bench_options* options)
+{
+    char* filename = strdup("/tmp/lexer_bench_XXXXXX.c");
+    int fd = mkstemps(filename, 2);
+    if(fd < 0){
+        free(filename);
+        return NULL;
+    }
+
+    FILE* fp = fdopen(fd, "w");
+    fprintf(fp, "// synthetic %s source\nvoid bench_%s(void)\n{\n", generator->name, generator->name);
+    while(ftell(fp) < (long)options->bytes){
+        generator->write_line(fp, options->depth);
+    }
+    fprintf(fp, "}\n");
+    fclose(fp);
+    return filename;
+}
+
+/*----------lexer and parser benchmark-----------*/
+struct bench_result
+{
+    size_t bytes;
+    int tokens;
+    double best_ms;
+    double parse_best_ms;
+    uint32_t ast_nodes;
+    // 语法树节点数组及类型表的字节数
+    size_t ast_bytes;
+    size_t allocations;
+    size_t allocated_bytes;
+};
+
+/**
+ * @brief 词法分析并语法分析一次filename，分别统计耗时，分配统计两者之和
+ *
+ * @return int 0成功
+ */
+static int bench_lex_once(const char* filename, struct bench_result* result)
+{
+    size_t allocations = bench_allocations;
+    size_t allocated_bytes = bench_allocated_bytes;
+    double start = bench_now_ms();
+
+    struct compile_process* compiler = compile_process_create(filename, "/dev/null", 0);
+    if(!compiler){
+        return -1;
+    }
+
+    struct lex_process_functions* functions = compiler->cfile.data ? &compiler_mmap_lex_functions : &compiler_lex_functions;
+    struct lex_process* lex_process = lex_process_create(compiler, functions, NULL);
+    vector_reserve(lex_process->token_vec, compiler->cfile.size / LEX_ESTIMATED_BYTES_PER_TOKEN);
+    int res = lex(lex_process);
+    double elapsed_ms = bench_now_ms() - start;
+    if(res != LEXICAL_ANALYSISI_ALL_OK){
+        lex_process_free(lex_process);
+        compile_process_free(compiler);
+        return -1;
+    }
+
+    compiler->token_vec = lex_process->token_vec;
+    start = bench_now_ms();
+    res = parse(compiler);
+    double parse_ms = bench_now_ms() - start;
+    if(res != PARSE_ALL_OK){
+        lex_process_free(lex_process);
+        compile_process_free(compiler);
+        return -1;
+    }
+
+    result->bytes = compiler->cfile.size;
+    result->tokens = vector_count(lex_process->token_vec);
+    if(0 == result->best_ms || elapsed_ms < result->best_ms){
+        result->best_ms = elapsed_ms;
+    }
+    if(0 == result->parse_best_ms || parse_ms < result->parse_best_ms){
+        result->parse_best_ms = parse_ms;
+    }
+    result->ast_nodes = compiler->ast->count - 1;
+    result->ast_bytes = ast_bytes(compiler->ast);
+    result->allocations = bench_allocations - allocations;
+    result->allocated_bytes = bench_allocated_bytes - allocated_bytes;
+
+    lex_process_free(lex_process);
+    compile_process_free(compiler);
+    return 0;
+}
+
+static void bench_print_json_string(const char* str)
+{
+    putchar('"');
+    for(; *str; str++){
+        if('"' == *str || '\\' == *str){
+            putchar('\\');
+        }
+        putchar(*str);
+    }
+    putchar('"');
+}
+
+/**
+ * @brief 在子进程中测试一个输入，峰值内存只统计这一个输入
+ *
+ * @param name 输出中的名字
+ * @param first 是否为第一项，决定是否先输出分隔的逗号
+ * @return int 0成功
+ */
+static int bench_run(const char* name, const char* filename, struct bench_options* options, bool first)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if(pid < 0){
+        return -1;
+    }
+
+    if(0 == pid){
+        struct bench_result result = {};
+        int res = 0;
+        for(int i = 0; i < options->iterations && 0 == res; i++){
+            res = bench_lex_once(filename, &result);
+        }
+        if(res != 0){
+            fprintf(stderr, "Failed to lex or parse %s\n", filename);
+            _exit(1);
+        }
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        double seconds = result.best_ms / 1000.0;
+        printf("%s    {\"name\": ", first ? "" : ",\n");
+        bench_print_json_string(name);
+        double parse_seconds = result.parse_best_ms / 1000.0;
+        printf(", \"bytes\": %zu, \"tokens\": %d, \"iterations\": %d, \"best_ms\": %.3f, "
+               "\"mb_per_s\": %.2f, \"tokens_per_s\": %.0f, \"parse_ms\": %.3f, "
+               "\"parse_tokens_per_s\": %.0f, \"ast_nodes\": %u, \"ast_bytes\": %zu, \"allocations\": %zu, "
+               "\"allocated_bytes\": %zu, \"peak_rss_kb\": %ld}",
+               result.bytes, result.tokens, options->iterations, result.best_ms,
+               result.bytes / (1024.0 * 1024.0) / seconds, result.tokens / seconds,
+               result.parse_best_ms, result.tokens / parse_seconds, result.ast_nodes, result.ast_bytes,
+               result.allocations, result.allocated_bytes, usage.ru_maxrss);
+        fflush(stdout);
+        _exit(0);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && 0 == WEXITSTATUS(status) ? 0 : -1;
+}
+
+/*----------keyword lookup microbenchmark-----------*/
+// 改为完美哈希之前的关键字判断，逐个strcmp
+static bool bench_keyword_chain(const char* str)
+{
+    return S_EQ(str, "void") || S_EQ(str, "char") || S_EQ(str, "int") || S_EQ(str, "float") ||
+           S_EQ(str, "double") || S_EQ(str, "short") || S_EQ(str, "long") || S_EQ(str, "signed") ||
+           S_EQ(str, "unsigned") || S_EQ(str, "struct") || S_EQ(str, "union") || S_EQ(str, "enum") ||
+           S_EQ(str, "typedef") || S_EQ(str, "sizeof") || S_EQ(str, "auto") || S_EQ(str, "static") ||
+           S_EQ(str, "register") || S_EQ(str, "extern") || S_EQ(str, "const") || S_EQ(str, "volatile") ||
+           S_EQ(str, "return") || S_EQ(str, "continue") || S_EQ(str, "break") || S_EQ(str, "goto") ||
+           S_EQ(str, "if") || S_EQ(str, "else") || S_EQ(str, "switch") || S_EQ(str, "case") ||
+           S_EQ(str, "default") || S_EQ(str, "for") || S_EQ(str, "do") || S_EQ(str, "while") ||
+           S_EQ(str, "__ignore_typecheck") || S_EQ(str, "include") || S_EQ(str, "restrict");
+}
+
+static void bench_keywords()
+{
+    // 关键字与普通标识符各半
+    static const char* words[] = {"int", "return", "while", "restrict", "value", "buffer_size", "i", "token_vec",
+                                  "struct", "if", "process", "unsigned", "lex_process", "x", "sizeof", "offset"};
+    const int total_words = sizeof(words) / sizeof(words[0]);
+    size_t lengths[sizeof(words) / sizeof(words[0])];
+    for(int i = 0; i < total_words; i++){
+        lengths[i] = strlen(words[i]);
+    }
+
+    const int rounds = 1000000;
+    volatile int hits = 0;
+    double start = bench_now_ms();
+    for(int r = 0; r < rounds; r++){
+        for(int i = 0; i < total_words; i++){
+            hits += bench_keyword_chain(words[i]);
+        }
+    }
+    double chain_ms = bench_now_ms() - start;
+
+    start = bench_now_ms();
+    for(int r = 0; r < rounds; r++){
+        for(int i = 0; i < total_words; i++){
+            hits += KEYWORD_NONE != keyword_lookup(words[i], lengths[i]);
+        }
+    }
+    double hash_ms = bench_now_ms() - start;
+
+    double lookups = (double)rounds * total_words;
+    printf("    \"keyword_chain_ns\": %.2f,\n", chain_ms * 1000000.0 / lookups);
+    printf("    \"keyword_perfect_hash_ns\": %.2f,\n", hash_ms * 1000000.0 / lookups);
+}
+
+/*----------vector push microbenchmark-----------*/
+static void bench_vector_push(int total_elements)
+{
+    struct token token = {};
+
+    // 改为倍增之前的扩容方式：每次只多申请VECTOR_ELEMENT_INCREMENT个元素
+    double start = bench_now_ms();
+    struct token* data = NULL;
+    int capacity = 0;
+    for(int i = 0; i < total_elements; i++){
+        if(i >= capacity){
+            capacity += VECTOR_ELEMENT_INCREMENT;
+            data = realloc(data, capacity * sizeof(struct token));
+        }
+        memcpy(&data[i], &token, sizeof(token));
+    }
+    double linear_ms = bench_now_ms() - start;
+    free(data);
+
+    start = bench_now_ms();
+    struct vector* vec = vector_create(sizeof(struct token));
+    for(int i = 0; i < total_elements; i++){
+        vector_push(vec, &token);
+    }
+    double geometric_ms = bench_now_ms() - start;
+    vector_free(vec);
+
+    printf("    \"vector_push_elements\": %d,\n", total_elements);
+    printf("    \"vector_push_linear_ms\": %.2f,\n", linear_ms);
+    printf("    \"vector_push_geometric_ms\": %.2f\n", geometric_ms);
+}
+
+int main(int argc, char** argv)
+{
+    struct bench_options options = {
+        .bytes = 4 * 1024 * 1024,
+        .iterations = 5,
+        .depth = 32,
+        .micro_elements = 10000000
+    };
+    struct vector* files = vector_create(sizeof(char*));
+    for(int i = 1; i < argc; i++){
+        if(S_EQ(argv[i], "-s") && i + 1 < argc){
+            options.bytes = strtoull(argv[++i], NULL, 10);
+        }
+        else if(S_EQ(argv[i], "-n") && i + 1 < argc){
+            options.iterations = atoi(argv[++i]);
+        }
+        else if(S_EQ(argv[i], "-d") && i + 1 < argc){
+            options.depth = atoi(argv[++i]);
+        }
+        else if(S_EQ(argv[i], "-m") && i + 1 < argc){
+            options.micro_elements = atoi(argv[++i]);
+        }
+        else{
+            vector_push(files, &argv[i]);
+        }
+    }
+    if(options.iterations < 1){
+        options.iterations = 1;
+    }
+
+    int failed = 0;
+    bool first = true;
+    printf("{\n  \"lexer\": [\n");
+    for(size_t i = 0; i < sizeof(bench_generators) / sizeof(bench_generators[0]); i++){
+        char* filename = bench_generate(&bench_generators[i], &options);
+        if(!filename){
+            fprintf(stderr, "Cannot create the %s source\n", bench_generators[i].name);
+            failed++;
+            continue;
+        }
+
+        if(bench_run(bench_generators[i].name, filename, &options, first) == 0){
+            first = false;
+        }
+        else{
+            failed++;
+        }
+        unlink(filename);
+        free(filename);
+    }
+
+    for(int i = 0; i < vector_count(files); i++){
+        const char* filename = *(char**)vector_at(files, i);
+        if(bench_run(filename, filename, &options, first) == 0){
+            first = false;
+        }
+        else{
+            failed++;
+        }
+    }
+    printf("\n  ]");
+
+    if(options.micro_elements > 0){
+        printf(",\n  \"micro\": {\n");
+        bench_keywords();
+        bench_vector_push(options.micro_elements);
+        printf("  }");
+    }
+    printf("\n}\n");
+
+    vector_free(files);
+    return failed ? 1 : 0;
+}
@@ -1,4 +1,5 @@
 #include "compiler.h"
+#include "helpers/vector.h"
 #include<stdarg.h>
 #include<stdlib.h>
 
@@ -8,6 +9,27 @@ struct lex_process_functions compiler_lex_functions = {
     .push_char = compile_process_push_char
 };
 
+struct lex_process_functions compiler_mmap_lex_functions = {
+    .next_char = compile_process_mmap_next_char,
+    .peek_char = compile_process_mmap_peek_char,
+    .push_char = compile_process_mmap_push_char,
+    .remaining = compile_process_mmap_remaining,
+    .skip = compile_process_mmap_skip
+};
+
+
+/**
+ * @brief 输出信息及pos处的行列号
+ * 
+ * @param pos 
+ * @param msg 
+ * @param args 
+ */
+static void compiler_vreport(struct pos pos, const char* msg, va_list args)
+{
+    vfprintf(stderr, msg, args);
+    fprintf(stderr, " on line %i, col %i in file %s\n", pos.line, pos.col, pos.filename);
+}
 
 /**
  * @brief 报错函数 
@@ -21,13 +43,44 @@ void compiler_error(struct compile_process* compiler, const char* msg, ...)
     //va_list处理可变参数
     va_list args;
     va_start(args, msg);
-    vfprintf(stderr, msg, args);
+    //行列号只在报错时由偏移算出
+    compiler_vreport(compile_process_pos(compiler, compiler->cfile.offset), msg, args);
     va_end(args);
+    exit(-1);
+}
 
-    fprintf(stderr, " on line %i, col %i in file %s\n", compiler->pos.line, compiler->pos.col, compiler->pos.filename);
+/**
+ * @brief 报告pos处的错误并退出，用于出错位置不是compiler读取游标的情况，如内存中的源码、切块分析
+ * 
+ * @param pos 
+ * @param msg 
+ * @param ... 
+ */
+void compiler_error_pos(struct pos pos, const char* msg, ...)
+{
+    va_list args;
+    va_start(args, msg);
+    compiler_vreport(pos, msg, args);
+    va_end(args);
     exit(-1);
 }
 
+/**
+ * @brief 报告offset处的错误但不退出，由调用者返回错误，多文件编译时不影响其他文件
+ * 
+ * @param compiler 
+ * @param offset 
+ * @param msg 
+ * @param ... 
+ */
+void compiler_report_error(struct compile_process* compiler, size_t offset, const char* msg, ...)
+{
+    va_list args;
+    va_start(args, msg);
+    compiler_vreport(compile_process_pos(compiler, offset), msg, args);
+    va_end(args);
+}
+
 /**
  * @brief 
  * 
@@ -40,10 +93,8 @@ void compiler_warning(struct compile_process* compiler, const char* msg, ...)
     //va_list处理可变参数
     va_list args;
     va_start(args, msg);
-    vfprintf(stderr, msg, args);
+    compiler_vreport(compile_process_pos(compiler, compiler->cfile.offset), msg, args);
     va_end(args);
-
-    fprintf(stderr, " on line %i, col %i in file %s\n", compiler->pos.line, compiler->pos.col, compiler->pos.filename);
 }
 
 int compile_file(const char* filename, const char* out_filename, int flags)
@@ -54,21 +105,60 @@ int compile_file(const char* filename, const char* out_filename, int flags)
     }
 
     //preform lexical analysis  词法分析
-    struct lex_process* lex_process = lex_process_create(process, &compiler_lex_functions, NULL);
+    //compile_process_create已映射的普通文件直接按游标读取，否则走文件流
+    struct lex_process_functions* functions = process->cfile.data ? &compiler_mmap_lex_functions : &compiler_lex_functions;
+    struct lex_process* lex_process = lex_process_create(process, functions, NULL);
     if(!lex_process){
+        compile_process_free(process);
         return COMPILER_FAILED_WITH_ERRORS;
     }
 
-    //具体词法分析lex
-    if(lex(lex_process) != LEXICAL_ANALYSISI_ALL_OK){
-        return COMPILER_FAILED_WITH_ERRORS;
+    //源文件内容未变时直接取用缓存的token，跳过词法分析
+    if(!token_cache_load(lex_process)){
+        //具体词法分析lex，大文件可切块并行分析
+        int res = 0;
+        if(process->flags & COMPILE_PROCESS_FLAG_PARALLEL_LEX){
+            res = lex_parallel(lex_process, 0);
+        }
+        else{
+            //按文件大小预估token数，避免词法分析过程中反复扩容
+            vector_reserve(lex_process->token_vec, process->cfile.size / LEX_ESTIMATED_BYTES_PER_TOKEN);
+            res = lex(lex_process);
+        }
+        if(res != LEXICAL_ANALYSISI_ALL_OK){
+            lex_process_free(lex_process);
+            compile_process_free(process);
+            return COMPILER_FAILED_WITH_ERRORS;
+        }
+        vector_shrink_to_fit(lex_process->token_vec);
+        token_cache_store(lex_process);
+    }
+
+    //token输出默认关闭，打开时整体格式化后一次写出
+    if(process->flags & COMPILE_PROCESS_FLAG_DUMP_TOKENS){
+        gdb_print_lexer_token_vec(lex_process);
+    }
+    if((process->flags & COMPILE_PROCESS_FLAG_DUMP_TOKENS_BINARY) && process->ofile){
+        fflush(process->ofile);
+        gdb_dump_lexer_token_vec_binary(lex_process, fileno(process->ofile));
     }
 
     process->token_vec = lex_process->token_vec;
     
     //preform parsing   语法分析
+    if(parse(process) != PARSE_ALL_OK){
+        lex_process_free(lex_process);
+        compile_process_free(process);
+        return COMPILER_FAILED_WITH_ERRORS;
+    }
+    if(process->flags & COMPILE_PROCESS_FLAG_DUMP_AST){
+        gdb_print_ast(process);
+    }
 
     //preform code generation   代码生成
 
+    //token_vec随lex_process一起释放
+    lex_process_free(lex_process);
+    compile_process_free(process);
     return COMPILER_FILE_COMPILED_OK;
 }
\ No newline at end of file
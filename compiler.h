@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 // micro function
@@ -18,47 +19,6 @@ struct pos
     const char *filename;
 };
 
-#define NUMERIC_CASE \
-    case '0':        \
-    case '1':        \
-    case '2':        \
-    case '3':        \
-    case '4':        \
-    case '5':        \
-    case '6':        \
-    case '7':        \
-    case '8':        \
-    case '9'
-
-#define OPERATOR_CASE_EXCLUDING_DIVISION \
-    case '+':                            \
-    case '-':                            \
-    case '*':                            \
-    case '>':                            \
-    case '<':                            \
-    case '^':                            \
-    case '%':                            \
-    case '!':                            \
-    case '=':                            \
-    case '~':                            \
-    case '|':                            \
-    case '&':                            \
-    case '(':                            \
-    case '[':                            \
-    case ',':                            \
-    case '.':                            \
-    case '?'
-
-#define SYMBOL_CASE \
-    case '{':       \
-    case '}':       \
-    case ':':       \
-    case ';':       \
-    case '#':       \
-    case '\\':      \
-    case ')':       \
-    case ']'
-
 // 词法分析结果状态
 enum
 {
@@ -79,22 +39,140 @@ enum
     TOKEN_TYPE_NEWLINE
 };
 
+// 关键字编号，由keyword.c中的完美哈希查得
+enum
+{
+    KEYWORD_NONE = -1,
+    KEYWORD_VOID,
+    KEYWORD_CHAR,
+    KEYWORD_INT,
+    KEYWORD_FLOAT,
+    KEYWORD_DOUBLE,
+    KEYWORD_SHORT,
+    KEYWORD_LONG,
+    KEYWORD_SIGNED,
+    KEYWORD_UNSIGNED,
+    KEYWORD_STRUCT,
+    KEYWORD_UNION,
+    KEYWORD_ENUM,
+    KEYWORD_TYPEDEF,
+    KEYWORD_SIZEOF,
+    KEYWORD_AUTO,
+    KEYWORD_STATIC,
+    KEYWORD_REGISTER,
+    KEYWORD_EXTERN,
+    KEYWORD_CONST,
+    KEYWORD_VOLATILE,
+    KEYWORD_RETURN,
+    KEYWORD_CONTINUE,
+    KEYWORD_BREAK,
+    KEYWORD_GOTO,
+    KEYWORD_IF,
+    KEYWORD_ELSE,
+    KEYWORD_SWITCH,
+    KEYWORD_CASE,
+    KEYWORD_DEFAULT,
+    KEYWORD_FOR,
+    KEYWORD_DO,
+    KEYWORD_WHILE,
+    KEYWORD_IGNORE_TYPECHECK,
+    KEYWORD_INCLUDE,
+    KEYWORD_RESTRICT,
+    KEYWORD_COUNT
+};
+
+// 运算符编号，由operator.c中的DFA识别
+enum
+{
+    OPERATOR_NONE = -1,
+    OPERATOR_LPAREN,
+    OPERATOR_LBRACKET,
+    OPERATOR_ARROW,
+    OPERATOR_DOT,
+    OPERATOR_NOT,
+    OPERATOR_BITWISE_NOT,
+    OPERATOR_INCREMENT,
+    OPERATOR_DECREMENT,
+    OPERATOR_MINUS,
+    OPERATOR_STAR,
+    OPERATOR_AMPERSAND,
+    OPERATOR_DIVIDE,
+    OPERATOR_MODULO,
+    OPERATOR_PLUS,
+    OPERATOR_LEFT_SHIFT,
+    OPERATOR_RIGHT_SHIFT,
+    OPERATOR_LESS,
+    OPERATOR_GREATER,
+    OPERATOR_LESS_EQUAL,
+    OPERATOR_GREATER_EQUAL,
+    OPERATOR_EQUAL,
+    OPERATOR_NOT_EQUAL,
+    OPERATOR_XOR,
+    OPERATOR_OR,
+    OPERATOR_LOGICAL_AND,
+    OPERATOR_LOGICAL_OR,
+    OPERATOR_QUESTION,
+    OPERATOR_ASSIGN,
+    OPERATOR_ADD_ASSIGN,
+    OPERATOR_SUB_ASSIGN,
+    OPERATOR_MUL_ASSIGN,
+    OPERATOR_DIV_ASSIGN,
+    OPERATOR_MOD_ASSIGN,
+    OPERATOR_LEFT_SHIFT_ASSIGN,
+    OPERATOR_RIGHT_SHIFT_ASSIGN,
+    OPERATOR_AND_ASSIGN,
+    OPERATOR_XOR_ASSIGN,
+    OPERATOR_OR_ASSIGN,
+    OPERATOR_COMMA,
+    OPERATOR_ELLIPSIS,
+    OPERATOR_COUNT
+};
+
 enum
 {
     NUMBER_TYPE_NORMAL,
     NUMBER_TYPE_LONG,
     NUMBER_TYPE_FLOAT,
-    NUMBER_TYPE_DOUBLE
+    NUMBER_TYPE_DOUBLE,
+    NUMBER_TYPE_LONG_LONG,
+    NUMBER_TYPE_LONG_DOUBLE
+};
+
+// 带u、U后缀的整数，与NUMBER_TYPE_XXX按位或
+#define NUMBER_TYPE_FLAG_UNSIGNED 0x100
+
+enum
+{
+    // 当两个token之间存在空白符
+    TOKEN_FLAG_WHITESPACE = 0b00000001,
+    // 省略换行时：token是所在行的第一个token，前面有被省略的换行
+    TOKEN_FLAG_NEWLINE = 0b00000010
 };
 
-// 词法单元
+// 词法单元，紧凑布局共16字节，一条cache line可容纳4个token
+// 行列号只在需要时由offset经行首索引算出，括号内字串放在lex_process的旁表中
 struct token
 {
-    int type;
-    int flag;
-    struct pos pos;
+    uint8_t type;
+    // TOKEN_FLAG_XXX
+    uint8_t flags;
+
+    // 根据type确定含义
+    union
+    {
+        // 关键字编号KEYWORD_XXX，sval指向关键字的静态字串
+        uint16_t keyword;
+        // 运算符编号OPERATOR_XXX，sval指向运算符的静态字串
+        uint16_t op;
+        // 数字类型NUMBER_TYPE_XXX，可带NUMBER_TYPE_FLAG_UNSIGNED
+        uint16_t num_type;
+    };
+
+    // token在源文件中的起始字节偏移
+    uint32_t offset;
 
     // 根据需要确定union共用体成员
+    // 标识符的sval为驻留字串，哈希值由token_identifier_hash取得
     union
     {
         char cval;          // 字符
@@ -102,34 +180,95 @@ struct token
         unsigned int inum;  // 普通整型
         unsigned long lnum; //
         unsigned long long llnum;
+        double dnum;        // 浮点数，num_type为FLOAT、DOUBLE或LONG_DOUBLE
         void *any;
     };
+};
 
-    struct token_number
-    {
-        int type;
-    } num;
-    // True：当两个token之间存在空白符
-    bool whitespace;
+_Static_assert(sizeof(struct token) == 16, "struct token should stay 16 bytes");
+
+// 最外层括号的旁表元素：括号内的token下标范围及源码区间
+struct token_between_brackets
+{
+    // 括号内第一个和最后一个token的下标
+    int first;
+    int last;
+    // 左括号之后到右括号之前的偏移区间[start, end)
+    uint32_t start;
+    uint32_t end;
+};
+
+// 行首偏移索引，用于由字节偏移计算行列号
+struct line_index
+{
+    // 元素为uint32_t
+    struct vector *line_starts;
+    // true：已完整扫描过整个源文件
+    bool complete;
+};
 
-    // 括号内字串
-    // 便于调试
-    const char *between_brackets;
+// 流式分析时的token环形缓冲，下标均为从0开始的token序号，按容量取模存放
+struct lex_token_ring
+{
+    struct token *tokens;
+    // 2的幂，只在检查点要求保留更多token时扩大
+    size_t capacity;
+    // 已生成的token数
+    size_t tail;
+    // 下一个交给调用者的token序号
+    size_t next;
+    // 检查点栈，元素为size_t，保存当时的next
+    struct vector *saves;
+    // 输入已读完
+    bool done;
+};
+
+// 环形缓冲的初始容量
+#define LEX_TOKEN_RING_INITIAL_CAPACITY 16
+
+// 增量分析延后的平移，编辑处之后的token和括号旁表不逐个改写，读取时再加上
+struct lex_pending_shift
+{
+    // 下标不小于token_from的token，偏移尚未加上offset
+    int token_from;
+    long offset;
+    // 下标不小于bracket_from的旁表元素，token下标尚未加上count，源码偏移尚未加上bracket_offset
+    int bracket_from;
+    int count;
+    long bracket_offset;
 };
 
 struct lex_process;
+struct arena;
+struct intern_table;
 // LEX_PROCESS_NEXT_CHAR:函数声明表达式  char (*pfun)(struct lex_process* process)
 // ？模拟java继承
 // 对应具体情况可以重写对应方法：implemente function and decide how it works
 typedef char (*LEX_PROCESS_NEXT_CHAR)(struct lex_process *process);
 typedef char (*LEX_PROCESS_PEEK_CHAR)(struct lex_process *process);
 typedef void (*LEX_PROCESS_PUSH_CHAR)(struct lex_process *process, char c);
+// 输入整体位于连续内存时返回剩余数据的起始地址，长度写入len
+typedef const char *(*LEX_PROCESS_REMAINING)(struct lex_process *process, size_t *len);
+// 跳过已批量扫描过的len个字节
+typedef void (*LEX_PROCESS_SKIP)(struct lex_process *process, size_t len);
 
 struct lex_process_functions
 {
     LEX_PROCESS_NEXT_CHAR next_char;
     LEX_PROCESS_PEEK_CHAR peek_char;
     LEX_PROCESS_PUSH_CHAR push_char;
+    // 可选，流式输入置NULL，词法分析退回逐字符读取
+    LEX_PROCESS_REMAINING remaining;
+    LEX_PROCESS_SKIP skip;
+};
+
+// 调用者提供的内存中的源码，直接在原数据上分析，不拷贝
+struct lex_memory_source
+{
+    const char *data;
+    size_t size;
+    // 下一个字符的偏移
+    size_t offset;
 };
 
 struct lex_process
@@ -144,62 +283,466 @@ struct lex_process
      *
      */
     int current_expression_count;
-    struct buffer *parentheses_buffer;
+    // 正在读入的最外层括号，遇到匹配的')'时补全end并写入between_brackets_vec
+    struct token_between_brackets open_brackets;
+    // 复用的临时缓冲，读完一个token后按实际长度拷入compiler->arena
+    struct buffer *token_buffer;
+    // 正在生成的token，每个lex_process各自一份，互不干扰
+    struct token tmp_token;
+
+    // 已读入的字节数，即下一个字符的偏移
+    size_t offset;
+    // 当前token的起始偏移
+    size_t token_start;
+    // 省略换行时使用：读过换行后尚未生成token，下一个token记为TOKEN_FLAG_NEWLINE
+    bool newline_pending;
+    // 省略换行时使用：正在读预处理指令，指令内的换行仍输出token
+    bool in_directive;
+    // 输入不是compiler的源文件时（如字串）使用的行首索引，NULL表示使用compiler->lines
+    struct line_index *lines;
+
+    // 最外层括号的旁表，按first升序，元素为struct token_between_brackets
+    struct vector *between_brackets_vec;
+    // lex_relex之后token_vec和旁表尾部尚未计入的平移，经lex_process_token_offset等读取
+    struct lex_pending_shift shift;
+    // 流式分析时token写入这里而不是token_vec，NULL表示一次性分析
+    struct lex_token_ring *ring;
     struct lex_process_functions *functions;
+    // 输入为内存中的源码时private指向这里
+    struct lex_memory_source memory;
 
     //
     void *private;
 };
 
+// 源码编辑：旧源码中[offset, offset + removed)被替换为新源码中[offset, offset + inserted)
+struct lex_edit
+{
+    size_t offset;
+    size_t removed;
+    size_t inserted;
+};
+
+// 预估平均每个token占用的源文件字节数，用于预先分配token_vec
+#define LEX_ESTIMATED_BYTES_PER_TOKEN 4
+
 enum
 {
     COMPILER_FILE_COMPILED_OK,
     COMPILER_FAILED_WITH_ERRORS
 };
 
+// compile_process->flags
+enum
+{
+    // 词法分析后以文本形式输出全部token到标准输出
+    COMPILE_PROCESS_FLAG_DUMP_TOKENS = 0b00000001,
+    // 词法分析后以二进制格式输出全部token到输出文件，供工具读取
+    COMPILE_PROCESS_FLAG_DUMP_TOKENS_BINARY = 0b00000010,
+    // 按源文件内容缓存词法分析结果，内容未变时跳过词法分析
+    COMPILE_PROCESS_FLAG_TOKEN_CACHE = 0b00000100,
+    // 大文件按行切块，多个线程同时做词法分析
+    COMPILE_PROCESS_FLAG_PARALLEL_LEX = 0b00001000,
+    // 跳过注释，不拷贝内容；换行只记为下一个token的TOKEN_FLAG_NEWLINE，
+    // 预处理指令内的换行仍输出换行token
+    COMPILE_PROCESS_FLAG_ELIDE_TRIVIA = 0b00010000,
+    // 语法分析后以文本形式输出语法树到标准输出
+    COMPILE_PROCESS_FLAG_DUMP_AST = 0b00100000
+};
+
+// 并行词法分析时每块至少这么大，更小的文件直接顺序分析
+#define LEX_PARALLEL_MIN_CHUNK_SIZE (1024 * 1024)
+// 块数为线程数的倍数，先做完的线程可以窃取剩下的块
+#define LEX_PARALLEL_CHUNKS_PER_WORKER 4
+
+// 二进制token转储：文件头，count个记录，最后是strings_size字节的字串区
+#define TOKEN_DUMP_MAGIC 0x4b544350 // "PCTK"
+#define TOKEN_DUMP_VERSION 1
+// 记录中没有字串的value
+#define TOKEN_DUMP_NO_STRING UINT64_MAX
+
+struct token_dump_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t strings_size;
+};
+
+struct token_dump_record
+{
+    uint8_t type;
+    uint8_t flags;
+    // keyword、op或num_type
+    uint16_t id;
+    uint32_t offset;
+    // 数字、字符的值，带字串的token为其在字串区中的偏移
+    uint64_t value;
+};
+
+// token缓存目录，缓存文件名为源文件内容的XXH64值
+#define TOKEN_CACHE_DIR "./.token_cache"
+#define TOKEN_CACHE_MAGIC 0x43544350 // "PCTC"
+#define TOKEN_CACHE_VERSION 2
+
+// 缓存文件：文件头，token，括号旁表，标识符偏移，字串区，各段按8字节对齐
+// token中的字串指针改存为字串区偏移，标识符前带有intern_header，载入后直接加入驻留表
+struct token_cache_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash;
+    uint64_t source_size;
+    // sizeof(struct token)，布局改变后旧缓存失效
+    uint32_t token_size;
+    uint32_t token_count;
+    uint32_t brackets_count;
+    uint32_t identifier_count;
+    uint32_t strings_size;
+    uint32_t reserved;
+};
+
+// 语法分析结果状态
+enum
+{
+    PARSE_ALL_OK,
+    PARSE_GENERAL_ERROR
+};
+
+// 语法树节点类别，子节点依次为[...]所列，可省略的子节点为NODE_TYPE_BLANK
+enum
+{
+    // 顶层声明和函数定义
+    NODE_TYPE_PROGRAM,
+    // 数字、字符、标识符，值取自token；相邻的字串token属于同一个字串节点
+    NODE_TYPE_NUMBER,
+    NODE_TYPE_IDENTIFIER,
+    NODE_TYPE_STRING,
+    // 二元、赋值、逗号运算：[left, right]；op为OPERATOR_LBRACKET时是下标，
+    // OPERATOR_DOT、OPERATOR_ARROW时是成员访问，right为成员名
+    NODE_TYPE_EXPRESSION,
+    // 一元运算：[operand]，后缀的++、--带NODE_FLAG_POSTFIX
+    NODE_TYPE_UNARY,
+    // 三目运算：[cond, then, else]
+    NODE_TYPE_TERNARY,
+    // 函数调用：[callee, args...]
+    NODE_TYPE_CALL,
+    // 类型转换：type_id为目标类型，[operand]
+    NODE_TYPE_CAST,
+    // sizeof：sizeof(类型)时type_id为该类型且没有子节点，否则[operand]
+    NODE_TYPE_SIZEOF,
+    // 复合字面量(type){...}：type_id为类型，[initializer_list]
+    NODE_TYPE_COMPOUND_LITERAL,
+    // 初始化列表：[elements...]
+    NODE_TYPE_INITIALIZER_LIST,
+    // 带指示符的初始化：[designators..., value]
+    NODE_TYPE_DESIGNATION,
+    // 指示符：op为OPERATOR_DOT时[member]，OPERATOR_LBRACKET时[index]
+    NODE_TYPE_DESIGNATOR,
+    // 变量、参数、结构体成员：type_id为类型，[initializer]或位域的[width]，也可没有子节点
+    NODE_TYPE_VARIABLE,
+    // 多个声明符的声明：type_id为共同的类型说明，[variables...]；只定义类型时没有子节点
+    NODE_TYPE_VARIABLE_LIST,
+    // 函数：type_id为函数类型，参数表为该类型的node；定义时[body]，声明时没有子节点
+    NODE_TYPE_FUNCTION,
+    // 枚举常量：[value]或没有子节点
+    NODE_TYPE_ENUMERATOR,
+    // 复合语句、结构体成员表、枚举常量表：[items...]
+    NODE_TYPE_BODY,
+    // [cond, then]或[cond, then, else]
+    NODE_TYPE_STATEMENT_IF,
+    // [cond, body]
+    NODE_TYPE_STATEMENT_WHILE,
+    // [body, cond]
+    NODE_TYPE_STATEMENT_DO_WHILE,
+    // [init, cond, step, body]
+    NODE_TYPE_STATEMENT_FOR,
+    // [cond, body]
+    NODE_TYPE_STATEMENT_SWITCH,
+    // [value, statement]
+    NODE_TYPE_STATEMENT_CASE,
+    // [statement]
+    NODE_TYPE_STATEMENT_DEFAULT,
+    // [value]或没有子节点
+    NODE_TYPE_STATEMENT_RETURN,
+    NODE_TYPE_STATEMENT_BREAK,
+    NODE_TYPE_STATEMENT_CONTINUE,
+    // token为标签名
+    NODE_TYPE_STATEMENT_GOTO,
+    // token为标签名，[statement]
+    NODE_TYPE_LABEL,
+    // 空语句或省略的表达式
+    NODE_TYPE_BLANK,
+    NODE_TYPE_COUNT
+};
+
+enum
+{
+    // 后缀的++、--
+    NODE_FLAG_POSTFIX = 0b00000001,
+    // 没有名字的参数或位域
+    NODE_FLAG_ANONYMOUS = 0b00000010,
+    // 子节点是位域宽度而不是初始值
+    NODE_FLAG_BITFIELD = 0b00000100
+};
+
+// 0号节点保留，表示没有节点
+#define NODE_ID_NONE 0
+// 0号类型保留，表示没有类型
+#define DATATYPE_ID_NONE 0
+
+// 类型类别
+enum
+{
+    DATATYPE_VOID,
+    DATATYPE_CHAR,
+    DATATYPE_SHORT,
+    DATATYPE_INT,
+    DATATYPE_LONG,
+    DATATYPE_LONG_LONG,
+    DATATYPE_FLOAT,
+    DATATYPE_DOUBLE,
+    DATATYPE_LONG_DOUBLE,
+    DATATYPE_STRUCT,
+    DATATYPE_UNION,
+    DATATYPE_ENUM,
+    // typedef定义的类型名
+    DATATYPE_TYPEDEF,
+    DATATYPE_POINTER,
+    DATATYPE_ARRAY,
+    DATATYPE_FUNCTION
+};
+
+enum
+{
+    DATATYPE_FLAG_SIGNED = 0b0000000000000001,
+    DATATYPE_FLAG_UNSIGNED = 0b0000000000000010,
+    DATATYPE_FLAG_CONST = 0b0000000000000100,
+    DATATYPE_FLAG_VOLATILE = 0b0000000000001000,
+    DATATYPE_FLAG_RESTRICT = 0b0000000000010000,
+    DATATYPE_FLAG_STATIC = 0b0000000000100000,
+    DATATYPE_FLAG_EXTERN = 0b0000000001000000,
+    DATATYPE_FLAG_AUTO = 0b0000000010000000,
+    DATATYPE_FLAG_REGISTER = 0b0000000100000000,
+    DATATYPE_FLAG_TYPEDEF = 0b0000001000000000,
+    DATATYPE_FLAG_IGNORE_TYPECHECK = 0b0000010000000000,
+    // 函数参数以...结尾
+    DATATYPE_FLAG_VARIADIC = 0b0000100000000000
+};
+
+// 类型，存储类别和限定符记在类型说明（最内层的base）上，指针的限定符记在指针上
+struct datatype
+{
+    // DATATYPE_XXX
+    uint8_t type;
+    // DATATYPE_FLAG_XXX
+    uint16_t flags;
+    // 指针指向的类型、数组元素类型、函数返回类型的编号
+    uint32_t base;
+    // 结构体、联合、枚举的标签或typedef名，驻留字串，可为NULL
+    const char *name;
+    // 数组长度表达式、函数参数表(NODE_TYPE_VARIABLE_LIST)、结构体或枚举的定义体(NODE_TYPE_BODY)的节点编号
+    uint32_t node;
+};
+
+// 语法树，节点的各个字段分别存为以32位节点编号为下标的平行数组，整棵树只占几块连续内存
+// 子节点总在父节点之前分配，按编号顺序扫描即为后序遍历
+struct ast
+{
+    // 已分配的节点数，含保留的0号
+    uint32_t count;
+    uint32_t capacity;
+    // NODE_TYPE_XXX
+    uint8_t *kind;
+    // NODE_FLAG_XXX
+    uint8_t *flags;
+    // 运算符节点的OPERATOR_XXX，其余为OPERATOR_NONE
+    int16_t *op;
+    // 代表节点的token在token_vec中的下标：运算符、声明的名字、语句的关键字等
+    uint32_t *token_index;
+    // 第一个子节点，其余子节点经next_sibling相连
+    uint32_t *first_child;
+    uint32_t *next_sibling;
+    // 声明、类型转换等节点的类型编号，其余为DATATYPE_ID_NONE
+    uint32_t *type_id;
+
+    // 类型表，以类型编号为下标
+    struct datatype *datatypes;
+    uint32_t datatype_count;
+    uint32_t datatype_capacity;
+
+    // NODE_TYPE_PROGRAM节点
+    uint32_t root;
+};
+
 struct compile_process
 {
     // flags:文件编译选项，指定文件按照何种方式进行编译
     int flags;
 
-    struct pos pos;
     struct compile_process_input_file
     {
         FILE *fp;
         const char *abs_path;
+
+        // 普通文件整体只读映射到内存，data为NULL时走stdio读取（如管道）
+        const char *data;
+        size_t size;
+        // 当前读取位置的字节偏移，报错时据此计算行列号
+        size_t offset;
     } cfile;
 
+    // 源文件行首索引：映射模式在首次查询时整体扫描，stdio模式边读边记录
+    struct line_index lines;
+
     //a vector of tokens from lexical analysis.
     struct vector* token_vec;
     FILE *ofile;
+
+    // token字串等编译期数据统一从arena分配，compile_process_free时一次释放
+    struct arena *arena;
+    // 标识符驻留表，相同拼写只保存一份，可直接比较指针
+    struct intern_table *interns;
+
+    // 命中的token缓存文件映射，token中的字串指向这里，compile_process_free时解除映射
+    struct compile_process_token_cache
+    {
+        uint64_t source_hash;
+        const char *data;
+        size_t size;
+    } token_cache;
+
+    // 语法分析得到的语法树，没有分析时为NULL
+    struct ast *ast;
 };
 
 /*---cprocess.c---*/
 struct compile_process *compile_process_create(const char *filename, const char *filename_out, int flags);
+void compile_process_free(struct compile_process *process);
+struct pos compile_process_pos(struct compile_process *process, size_t offset);
 // 读取文件流字符
 char compile_process_next_char(struct lex_process *lex_process);
 char compile_process_peek_char(struct lex_process *lex_process);
 void compile_process_push_char(struct lex_process *lex_process, char c);
+// 读取内存映射文件字符
+char compile_process_mmap_next_char(struct lex_process *lex_process);
+char compile_process_mmap_peek_char(struct lex_process *lex_process);
+void compile_process_mmap_push_char(struct lex_process *lex_process, char c);
+const char *compile_process_mmap_remaining(struct lex_process *lex_process, size_t *len);
+void compile_process_mmap_skip(struct lex_process *lex_process, size_t len);
 
 /*---compile.c---*/
+// 文件流与内存映射文件两种输入对应的读取函数
+extern struct lex_process_functions compiler_lex_functions;
+extern struct lex_process_functions compiler_mmap_lex_functions;
 int compile_file(const char *filename, const char *out_filename, int flags);
 
 // 编译帮助
 void compiler_error(struct compile_process *compiler, const char *msg, ...);
+void compiler_error_pos(struct pos pos, const char *msg, ...);
 void compiler_warning(struct compile_process *compiler, const char *msg, ...);
+void compiler_report_error(struct compile_process *compiler, size_t offset, const char *msg, ...);
 
 /*---lex_process.c---*/
 // 词法分析
 struct lex_process *lex_process_create(struct compile_process *compiler, struct lex_process_functions *functions, void *private);
+// 直接读取[data, data + size)，分析期间data须保持有效，token不引用data
+struct lex_process *lex_process_create_for_memory(struct compile_process *compiler, const char *data, size_t size);
 void lex_process_free(struct lex_process *process);
 void *lex_process_private(struct lex_process *process);
 struct vector *lex_process_vector(struct lex_process *process);
+struct pos lex_process_pos(struct lex_process *process, size_t offset);
+struct pos lex_process_token_pos(struct lex_process *process, int index);
+// 以下读取计入lex_relex延后的平移
+size_t lex_process_token_offset(struct lex_process *process, int index);
+struct token_between_brackets lex_process_brackets_at(struct lex_process *process, int group);
+bool lex_process_token_between_brackets(struct lex_process *process, int index, struct token_between_brackets *brackets);
+// 把延后的平移写回token_vec和旁表，之后可以直接读取token->offset，代价与token数成正比
+void lex_process_apply_shift(struct lex_process *process);
 
 /*---lexer.c----*/
+// 内存中的源码对应的读取函数
+extern struct lex_process_functions lexer_memory_functions;
 int lex(struct lex_process *process);
+// 分块分析：从当前偏移读到输入结尾，起点处的括号深度未知
+int lex_chunk(struct lex_process *process, struct token *context);
+int lex_token_paren_delta(struct token *token);
+// 流式分析：按需读入token，返回的指针在下次调用前有效，读完返回NULL
+struct token *lex_next_token(struct lex_process *process);
+struct token *lex_peek_token(struct lex_process *process);
+// 检查点，用法同vector_save/vector_restore/vector_save_purge
+void lex_save(struct lex_process *process);
+void lex_restore(struct lex_process *process);
+void lex_save_purge(struct lex_process *process);
+// 增量分析：source为编辑后的完整源码，只重新分析编辑处附近直到与旧token重新同步
+// 之后的token偏移和括号旁表只记录平移，交给直接读取token->offset的代码前先调用lex_process_apply_shift
+int lex_relex(struct lex_process *process, const char *source, size_t size, struct lex_edit *edit);
+struct lex_process *tokens_build_for_memory(struct compile_process *compiler, const char *data, size_t size);
 struct lex_process *tokens_build_for_string(struct compile_process *compiler, const char *str);
 
+/*---lex_scan.c---*/
+// 在连续内存上批量扫描，返回从p起满足条件的字节数
+size_t lex_scan_identifier(const char *p, size_t len);
+size_t lex_scan_digits(const char *p, size_t len);
+size_t lex_scan_blank(const char *p, size_t len);
+size_t lex_scan_line(const char *p, size_t len);
+size_t lex_scan_comment_end(const char *p, size_t len);
+size_t lex_scan_code(const char *p, size_t len);
+
+/*---line_index.c---*/
+void line_index_init(struct line_index *lines);
+void line_index_free(struct line_index *lines);
+void line_index_add_line(struct line_index *lines, size_t offset);
+void line_index_build(struct line_index *lines, const char *data, size_t size);
+void line_index_edit(struct line_index *lines, const char *data, size_t offset, size_t removed, size_t inserted);
+struct pos line_index_pos(struct line_index *lines, size_t offset);
+
+/*---lex_parallel.c---*/
+// 映射到内存的源文件切块并行分析，结果与lex相同；total_workers为0时等于CPU核数
+int lex_parallel(struct lex_process *process, int total_workers);
+
+/*---ast.c---*/
+// capacity为预计的节点数，不够时自动扩容
+struct ast *ast_create(uint32_t capacity);
+void ast_free(struct ast *ast);
+// 分配一个节点，first_child及其后的兄弟节点应已链好
+uint32_t ast_node(struct ast *ast, int kind, uint32_t token_index, uint32_t first_child);
+uint32_t ast_datatype(struct ast *ast, int type, uint32_t base);
+uint32_t ast_child_count(struct ast *ast, uint32_t node);
+// 节点数组和类型表占用的字节数
+size_t ast_bytes(struct ast *ast);
+
+/*---parser.c---*/
+// 分析compile_process->token_vec，语法树写入compile_process->ast
+int parse(struct compile_process *process);
+
+/*---token_cache.c---*/
+bool token_cache_load(struct lex_process *lex_process);
+void token_cache_store(struct lex_process *lex_process);
+
+/*---gdb_debug.c---*/
+struct buffer;
+void gdb_format_lexer_token_vec(struct buffer *buffer, struct lex_process *lex_process);
+void gdb_print_lexer_token_vec(struct lex_process *lex_process);
+void gdb_dump_lexer_token_vec_binary(struct lex_process *lex_process, int fd);
+void gdb_format_ast(struct buffer *buffer, struct compile_process *process);
+void gdb_print_ast(struct compile_process *process);
+
 /*---token.c---*/
 bool token_is_keyword(struct token *token, const char *value);
+bool token_is_keyword_id(struct token *token, int keyword);
+bool token_is_floating(struct token *token);
+unsigned int token_identifier_hash(struct token *token);
+
+/*---keyword.c---*/
+int keyword_lookup(const char *str, size_t len);
+const char *keyword_name(int keyword);
+
+/*---operator.c---*/
+// 运算符DFA初始状态
+#define OPERATOR_DFA_START 0
+int operator_dfa_next(int state, char c);
+int operator_dfa_accept(int state);
+const char *operator_name(int op);
 
 #endif
\ No newline at end of file
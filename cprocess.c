@@ -1,6 +1,36 @@
 #include<stdio.h>
 #include<stdlib.h>
+#include<assert.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
 #include "compiler.h"
+#include "lex_input.h"
+#include "helpers/arena.h"
+#include "helpers/intern.h"
+
+/**
+ * @brief 普通文件整体只读映射到内存，管道等无法映射的输入保持stdio读取
+ * 
+ * @param cfile 
+ * @return true 映射成功
+ */
+static bool compile_process_map_file(struct compile_process_input_file* cfile)
+{
+    struct stat st;
+    if(fstat(fileno(cfile->fp), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0){
+        return false;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(cfile->fp), 0);
+    if(MAP_FAILED == data){
+        return false;
+    }
+
+    cfile->data = data;
+    cfile->size = st.st_size;
+    cfile->offset = 0;
+    return true;
+}
 
 struct compile_process* compile_process_create(const char* filename, const char* filename_out, int flags)
 {
@@ -20,11 +50,62 @@ struct compile_process* compile_process_create(const char* filename, const char*
     struct compile_process* process = calloc(1, sizeof(struct compile_process));
     process->flags = flags;
     process->cfile.fp = file;
+    process->cfile.abs_path = filename;
     process->ofile = out_file;
+    line_index_init(&process->lines);
+    process->arena = arena_create();
+    process->interns = intern_table_create(process->arena);
+
+    // 映射成功后不再需要文件流
+    if(compile_process_map_file(&process->cfile)){
+        fclose(file);
+        process->cfile.fp = NULL;
+    }
 
     return process;
 }
 
+void compile_process_free(struct compile_process* process)
+{
+    if(process->cfile.data){
+        munmap((void*)process->cfile.data, process->cfile.size);
+    }
+    if(process->cfile.fp){
+        fclose(process->cfile.fp);
+    }
+    if(process->ofile){
+        fclose(process->ofile);
+    }
+    if(process->token_cache.data){
+        munmap((void*)process->token_cache.data, process->token_cache.size);
+    }
+    if(process->ast){
+        ast_free(process->ast);
+    }
+    line_index_free(&process->lines);
+    intern_table_free(process->interns);
+    arena_free(process->arena);
+    free(process);
+}
+
+/**
+ * @brief 由字节偏移计算行列号，只在报错或调试输出时调用
+ * 
+ * @param process 
+ * @param offset 
+ * @return struct pos 
+ */
+struct pos compile_process_pos(struct compile_process* process, size_t offset)
+{
+    if(process->cfile.data && !process->lines.complete){
+        line_index_build(&process->lines, process->cfile.data, process->cfile.size);
+    }
+
+    struct pos pos = line_index_pos(&process->lines, offset);
+    pos.filename = process->cfile.abs_path;
+    return pos;
+}
+
 /**
  * @brief 从文件中读入一字符
  * as default function
@@ -33,19 +114,7 @@ struct compile_process* compile_process_create(const char* filename, const char*
  */
 char compile_process_next_char(struct lex_process* lex_process)
 {
-    struct compile_process* compiler = lex_process->compiler;
-    //每次从fileStream读入1字符
-    //列+1
-    compiler->pos.col +=1;
-    char c = getc(compiler->cfile.fp);
-
-    //读到换行置位col并++line
-    if('\n' == c){
-        compiler->pos.col = 1;
-        compiler->pos.line += 1;
-    }
-
-    return c;
+    return lex_input_stream_next(lex_process->compiler);
 }
 
 /**
@@ -56,12 +125,7 @@ char compile_process_next_char(struct lex_process* lex_process)
  */
 char compile_process_peek_char(struct lex_process* lex_process)
 {
-    struct compile_process* compiler = lex_process->compiler;
-    //从文件流中读一个后放回
-    char c = getc(compiler->cfile.fp);
-    ungetc(c, compiler->cfile.fp);
-
-    return c;
+    return lex_input_stream_peek(lex_process->compiler);
 }
 
 /**
@@ -72,6 +136,48 @@ char compile_process_peek_char(struct lex_process* lex_process)
  */
 void  compile_process_push_char(struct lex_process* lex_process, char c)
 {
-    struct compile_process* complier = lex_process->compiler;
-    ungetc(c, complier->cfile.fp);
+    lex_input_stream_push(lex_process->compiler, c);
+}
+
+/**
+ * @brief 从映射内存中读入一字符，只移动游标
+ * 
+ * @param lex_process 
+ * @return char 
+ */
+char compile_process_mmap_next_char(struct lex_process* lex_process)
+{
+    struct compile_process* compiler = lex_process->compiler;
+    //行列号由行首索引按需计算
+    return lex_input_buffer_next(compiler->cfile.data, compiler->cfile.size, &compiler->cfile.offset);
+}
+
+char compile_process_mmap_peek_char(struct lex_process* lex_process)
+{
+    struct compile_process* compiler = lex_process->compiler;
+    return lex_input_buffer_peek(compiler->cfile.data, compiler->cfile.size, compiler->cfile.offset);
+}
+
+/**
+ * @brief 回退游标，只能退回刚读过的字符
+ * 
+ * @param lex_process 
+ * @param c 
+ */
+void compile_process_mmap_push_char(struct lex_process* lex_process, char c)
+{
+    struct compile_process* compiler = lex_process->compiler;
+    lex_input_buffer_push(compiler->cfile.data, &compiler->cfile.offset, c);
+}
+
+const char* compile_process_mmap_remaining(struct lex_process* lex_process, size_t* len)
+{
+    struct compile_process* compiler = lex_process->compiler;
+    return lex_input_buffer_remaining(compiler->cfile.data, compiler->cfile.size, compiler->cfile.offset, len);
+}
+
+void compile_process_mmap_skip(struct lex_process* lex_process, size_t len)
+{
+    struct compile_process* compiler = lex_process->compiler;
+    lex_input_buffer_skip(compiler->cfile.size, &compiler->cfile.offset, len);
 }
\ No newline at end of file
@@ -1,50 +1,306 @@
 #include "compiler.h"
 #include "helpers/vector.h"
+#include "helpers/arena.h"
+#include "helpers/buffer.h"
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
-void gdb_print_lexer_token(struct token* token)
+void gdb_format_lexer_token(struct buffer* buffer, struct token* token)
 {
     switch (token->type)
     {
     case TOKEN_TYPE_NUMBER:
-        printf("<type: number, value: %lld>", token->llnum);
+        if(token_is_floating(token)){
+            buffer_printf(buffer, "<type: number, value: %g>", token->dnum);
+            break;
+        }
+        buffer_printf(buffer, "<type: number, value: %lld>", token->llnum);
         break;
     case TOKEN_TYPE_NEWLINE:
-        printf("<type: newline, value: \\n>");
+        buffer_printf(buffer, "<type: newline, value: \\n>");
         break;
     case TOKEN_TYPE_COMMENT:
-        printf("comments");
+        buffer_printf(buffer, "comments");
         break;
     case TOKEN_TYPE_SYMBOL:
-        printf("<type: symbol, value: %c>", token->cval);
+        buffer_printf(buffer, "<type: symbol, value: %c>", token->cval);
         break;
     case TOKEN_TYPE_IDENTIFIER:
-        printf("<type: identifier, value: %s>", token->sval);
+        buffer_printf(buffer, "<type: identifier, value: %s>", token->sval);
         break;
     case TOKEN_TYPE_KEYWORD:
-        printf("<type: keyword, value: %s>", token->sval);
+        buffer_printf(buffer, "<type: keyword, value: %s>", token->sval);
         break;
     case TOKEN_TYPE_STRING:
-        printf("<type: string, value: %s>", token->sval);
+        buffer_printf(buffer, "<type: string, value: %s>", token->sval);
         break;
     case TOKEN_TYPE_OPERATOR:
-        printf("<type: operator, value: %s>", token->sval);
+        buffer_printf(buffer, "<type: operator, value: %s>", token->sval);
         break;
     default:
-        printf("Unknow type!\n");
+        buffer_printf(buffer, "Unknow type!\n");
         break;
     }
 }
 
+/**
+ * @brief 写出全部数据，write可能只写出一部分
+ * 
+ * @param fd 
+ * @param data 
+ * @param len 
+ */
+static void gdb_write_all(int fd, const char* data, size_t len)
+{
+    while(len > 0){
+        ssize_t written = write(fd, data, len);
+        if(written <= 0){
+            return;
+        }
+        data += written;
+        len -= written;
+    }
+}
+
+/**
+ * @brief 以文本形式把全部token格式化到buffer
+ * 
+ * @param buffer 
+ * @param lex_process 
+ */
+void gdb_format_lexer_token_vec(struct buffer* buffer, struct lex_process *lex_process)
+{
+    struct vector *token_vec = lex_process->token_vec;
+    buffer_printf(buffer, "token count:%d, arena bytes used:%zu\n", vector_count(token_vec), arena_used(lex_process->compiler->arena));
+    for (int i = 0; i < vector_count(token_vec); ++i)
+    {
+        struct pos pos = lex_process_token_pos(lex_process, i);
+        buffer_printf(buffer, "token:%d (line %d, col %d) ", i+1, pos.line, pos.col);
+        gdb_format_lexer_token(buffer, (struct token*)(vector_at(token_vec,i)));
+        buffer_write(buffer, '\n');
+    }
+}
 
+/**
+ * @brief 以文本形式输出全部token，先格式化到一块缓冲，再一次写到标准输出
+ * 
+ * @param lex_process 
+ */
 void gdb_print_lexer_token_vec(struct lex_process *lex_process)
+{
+    struct buffer* buffer = buffer_create();
+    gdb_format_lexer_token_vec(buffer, lex_process);
+
+    // 之前经stdio输出的内容先写出，保持顺序
+    fflush(stdout);
+    gdb_write_all(STDOUT_FILENO, buffer_ptr(buffer), buffer->len);
+    buffer_free(buffer);
+}
+
+static uint64_t gdb_dump_token_value(struct buffer* strings, struct token* token)
+{
+    switch (token->type)
+    {
+    case TOKEN_TYPE_NUMBER:
+        return token->llnum;
+    case TOKEN_TYPE_SYMBOL:
+        return token->cval;
+    case TOKEN_TYPE_NEWLINE:
+        return 0;
+    default:
+        break;
+    }
+
+    if(!token->sval){
+        return TOKEN_DUMP_NO_STRING;
+    }
+
+    // 字串连同结束符写入字串区
+    uint64_t offset = strings->len;
+    buffer_write_bytes(strings, token->sval, strlen(token->sval) + 1);
+    return offset;
+}
+
+/**
+ * @brief 以二进制格式输出全部token，格式见struct token_dump_header
+ * 
+ * @param lex_process 
+ * @param fd 
+ */
+void gdb_dump_lexer_token_vec_binary(struct lex_process *lex_process, int fd)
 {
     struct vector *token_vec = lex_process->token_vec;
-    printf("token count:%d\n", vector_count(token_vec));
+    struct buffer* out = buffer_create();
+    struct buffer* strings = buffer_create();
+    struct token_dump_header header = {
+        .magic = TOKEN_DUMP_MAGIC,
+        .version = TOKEN_DUMP_VERSION,
+        .count = vector_count(token_vec)
+    };
+    buffer_write_bytes(out, &header, sizeof(header));
     for (int i = 0; i < vector_count(token_vec); ++i)
     {
-        printf("token:%d ", i+1);
-        gdb_print_lexer_token((struct token*)(vector_at(token_vec,i)));
-        printf("\n");
+        struct token* token = vector_at(token_vec, i);
+        struct token_dump_record record = {
+            .type = token->type,
+            .flags = token->flags,
+            .id = token->keyword,
+            .offset = token->offset,
+            .value = gdb_dump_token_value(strings, token)
+        };
+        buffer_write_bytes(out, &record, sizeof(record));
     }
-}
\ No newline at end of file
+
+    // 字串区大小在写完记录后才知道，回填文件头
+    header.strings_size = strings->len;
+    memcpy(buffer_ptr(out), &header, sizeof(header));
+    buffer_write_bytes(out, buffer_ptr(strings), strings->len);
+
+    gdb_write_all(fd, buffer_ptr(out), out->len);
+    buffer_free(strings);
+    buffer_free(out);
+}
+static const char* gdb_node_type_names[NODE_TYPE_COUNT] = {
+    [NODE_TYPE_PROGRAM] = "program",
+    [NODE_TYPE_NUMBER] = "number",
+    [NODE_TYPE_IDENTIFIER] = "identifier",
+    [NODE_TYPE_STRING] = "string",
+    [NODE_TYPE_EXPRESSION] = "expression",
+    [NODE_TYPE_UNARY] = "unary",
+    [NODE_TYPE_TERNARY] = "ternary",
+    [NODE_TYPE_CALL] = "call",
+    [NODE_TYPE_CAST] = "cast",
+    [NODE_TYPE_SIZEOF] = "sizeof",
+    [NODE_TYPE_COMPOUND_LITERAL] = "compound literal",
+    [NODE_TYPE_INITIALIZER_LIST] = "initializer list",
+    [NODE_TYPE_DESIGNATION] = "designation",
+    [NODE_TYPE_DESIGNATOR] = "designator",
+    [NODE_TYPE_VARIABLE] = "variable",
+    [NODE_TYPE_VARIABLE_LIST] = "variable list",
+    [NODE_TYPE_FUNCTION] = "function",
+    [NODE_TYPE_ENUMERATOR] = "enumerator",
+    [NODE_TYPE_BODY] = "body",
+    [NODE_TYPE_STATEMENT_IF] = "if",
+    [NODE_TYPE_STATEMENT_WHILE] = "while",
+    [NODE_TYPE_STATEMENT_DO_WHILE] = "do while",
+    [NODE_TYPE_STATEMENT_FOR] = "for",
+    [NODE_TYPE_STATEMENT_SWITCH] = "switch",
+    [NODE_TYPE_STATEMENT_CASE] = "case",
+    [NODE_TYPE_STATEMENT_DEFAULT] = "default",
+    [NODE_TYPE_STATEMENT_RETURN] = "return",
+    [NODE_TYPE_STATEMENT_BREAK] = "break",
+    [NODE_TYPE_STATEMENT_CONTINUE] = "continue",
+    [NODE_TYPE_STATEMENT_GOTO] = "goto",
+    [NODE_TYPE_LABEL] = "label",
+    [NODE_TYPE_BLANK] = "blank"
+};
+
+static const char* gdb_datatype_names[] = {
+    [DATATYPE_VOID] = "void",
+    [DATATYPE_CHAR] = "char",
+    [DATATYPE_SHORT] = "short",
+    [DATATYPE_INT] = "int",
+    [DATATYPE_LONG] = "long",
+    [DATATYPE_LONG_LONG] = "long long",
+    [DATATYPE_FLOAT] = "float",
+    [DATATYPE_DOUBLE] = "double",
+    [DATATYPE_LONG_DOUBLE] = "long double",
+    [DATATYPE_STRUCT] = "struct",
+    [DATATYPE_UNION] = "union",
+    [DATATYPE_ENUM] = "enum",
+    [DATATYPE_TYPEDEF] = "typedef",
+    [DATATYPE_POINTER] = "pointer to",
+    [DATATYPE_ARRAY] = "array of",
+    [DATATYPE_FUNCTION] = "function returning"
+};
+
+/**
+ * @brief 类型由外向内输出，如pointer to function returning int
+ * 
+ * @param buffer 
+ * @param datatype 
+ */
+static void gdb_format_datatype(struct buffer* buffer, struct ast* ast, uint32_t id)
+{
+    for(; id != DATATYPE_ID_NONE; id = ast->datatypes[id].base){
+        struct datatype* datatype = &ast->datatypes[id];
+        if(datatype->flags & DATATYPE_FLAG_CONST){
+            buffer_printf(buffer, "const ");
+        }
+        if(datatype->flags & DATATYPE_FLAG_UNSIGNED){
+            buffer_printf(buffer, "unsigned ");
+        }
+        buffer_printf(buffer, "%s", gdb_datatype_names[datatype->type]);
+        if(datatype->name){
+            buffer_printf(buffer, " %s", datatype->name);
+        }
+        if(datatype->base){
+            buffer_write(buffer, ' ');
+        }
+    }
+}
+
+static void gdb_format_node(struct buffer* buffer, struct token* tokens, struct ast* ast, uint32_t node, int depth)
+{
+    for(int i = 0; i < depth; i++){
+        buffer_printf(buffer, "  ");
+    }
+    int kind = ast->kind[node];
+    buffer_printf(buffer, "%s", gdb_node_type_names[kind]);
+
+    // 节点的token：运算符、名字、字面量或关键字
+    if(NODE_TYPE_PROGRAM != kind && NODE_TYPE_BLANK != kind){
+        buffer_printf(buffer, " ");
+        gdb_format_lexer_token(buffer, &tokens[ast->token_index[node]]);
+    }
+    if(ast->flags[node] & NODE_FLAG_POSTFIX){
+        buffer_printf(buffer, " postfix");
+    }
+    if(ast->type_id[node] != DATATYPE_ID_NONE){
+        buffer_printf(buffer, " : ");
+        gdb_format_datatype(buffer, ast, ast->type_id[node]);
+    }
+    buffer_write(buffer, '\n');
+
+    // 参数表、成员表挂在类型上，随节点一起输出
+    for(uint32_t id = ast->type_id[node]; id != DATATYPE_ID_NONE; id = ast->datatypes[id].base){
+        if(ast->datatypes[id].node != NODE_ID_NONE){
+            gdb_format_node(buffer, tokens, ast, ast->datatypes[id].node, depth + 1);
+        }
+    }
+    for(uint32_t child = ast->first_child[node]; child != NODE_ID_NONE; child = ast->next_sibling[child]){
+        gdb_format_node(buffer, tokens, ast, child, depth + 1);
+    }
+}
+
+/**
+ * @brief 以缩进的文本形式把语法树格式化到buffer
+ * 
+ * @param buffer 
+ * @param process 
+ */
+void gdb_format_ast(struct buffer* buffer, struct compile_process *process)
+{
+    struct ast* ast = process->ast;
+    if(ast){
+        buffer_printf(buffer, "ast of %s, nodes:%u, datatypes:%u, bytes:%zu\n", process->cfile.abs_path,
+                      ast->count - 1, ast->datatype_count - 1, ast_bytes(ast));
+        gdb_format_node(buffer, vector_data_ptr(process->token_vec), ast, ast->root, 0);
+    }
+}
+
+/**
+ * @brief 以缩进的文本形式输出语法树，先格式化到一块缓冲，再一次写到标准输出
+ * 
+ * @param process 
+ */
+void gdb_print_ast(struct compile_process *process)
+{
+    struct buffer* buffer = buffer_create();
+    gdb_format_ast(buffer, process);
+
+    fflush(stdout);
+    gdb_write_all(STDOUT_FILENO, buffer_ptr(buffer), buffer->len);
+    buffer_free(buffer);
+}
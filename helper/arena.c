@@ -0,0 +1,97 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+static struct arena_block* arena_block_create(size_t size)
+{
+    struct arena_block* block = malloc(sizeof(struct arena_block) + size);
+    assert(block);
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+struct arena* arena_create()
+{
+    struct arena* arena = calloc(sizeof(struct arena), 1);
+    arena->head = arena_block_create(ARENA_BLOCK_SIZE);
+    return arena;
+}
+
+void* arena_alloc_aligned(struct arena* arena, size_t size, size_t align)
+{
+    struct arena_block* block = arena->head;
+    uintptr_t base = (uintptr_t)block->data;
+    size_t start = ((base + block->used + align - 1) & ~(uintptr_t)(align - 1)) - base;
+    if (start + size > block->size)
+    {
+        // Oversized requests get a block of their own so the current block keeps its free space
+        if (size + align > ARENA_BLOCK_SIZE / 4)
+        {
+            struct arena_block* big = arena_block_create(size + align);
+            big->next = block->next;
+            block->next = big;
+            block = big;
+        }
+        else
+        {
+            block = arena_block_create(ARENA_BLOCK_SIZE);
+            block->next = arena->head;
+            arena->head = block;
+        }
+
+        base = (uintptr_t)block->data;
+        start = ((base + align - 1) & ~(uintptr_t)(align - 1)) - base;
+    }
+
+    block->used = start + size;
+    arena->used += size;
+    return block->data + start;
+}
+
+void* arena_alloc(struct arena* arena, size_t size)
+{
+    return arena_alloc_aligned(arena, size, sizeof(void*));
+}
+
+const char* arena_strndup(struct arena* arena, const char* str, size_t len)
+{
+    char* ptr = arena_alloc_aligned(arena, len + 1, 1);
+    memcpy(ptr, str, len);
+    ptr[len] = 0x00;
+    return ptr;
+}
+
+size_t arena_used(struct arena* arena)
+{
+    return arena->used;
+}
+
+void arena_adopt(struct arena* arena, struct arena* other)
+{
+    // Keep allocating from our own head block, the adopted ones go behind it
+    struct arena_block* tail = other->head;
+    while (tail->next)
+    {
+        tail = tail->next;
+    }
+    tail->next = arena->head->next;
+    arena->head->next = other->head;
+    arena->used += other->used;
+    free(other);
+}
+
+void arena_free(struct arena* arena)
+{
+    struct arena_block* block = arena->head;
+    while (block)
+    {
+        struct arena_block* next = block->next;
+        free(block);
+        block = next;
+    }
+    free(arena);
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Size of each block the arena grabs from malloc, bigger requests get their own block
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+struct arena_block
+{
+    struct arena_block* next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+// Bump allocator, everything allocated here is released together with arena_free
+struct arena
+{
+    struct arena_block* head;
+    // Total bytes handed out to callers
+    size_t used;
+};
+
+struct arena* arena_create();
+
+void* arena_alloc(struct arena* arena, size_t size);
+void* arena_alloc_aligned(struct arena* arena, size_t size, size_t align);
+/**
+ * Copies len bytes of str into the arena and terminates it with a null byte
+ */
+const char* arena_strndup(struct arena* arena, const char* str, size_t len);
+size_t arena_used(struct arena* arena);
+/**
+ * Moves every block of other into arena and frees other.
+ * Memory handed out by other stays valid until arena_free(arena)
+ */
+void arena_adopt(struct arena* arena, struct arena* other);
+void arena_free(struct arena* arena);
+
+#endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 
 struct buffer* buffer_create()
 {
@@ -28,16 +29,32 @@ void buffer_need(struct buffer* buffer, size_t size)
 }
 
 
+/**
+ * Formats into the end of the buffer, growing it to the exact length needed.
+ * Returns the number of characters written, not counting the terminator
+ */
+static int buffer_vprintf(struct buffer* buffer, const char* fmt, va_list args)
+{
+    va_list measure;
+    va_copy(measure, args);
+    int actual_len = vsnprintf(NULL, 0, fmt, measure);
+    va_end(measure);
+    if (actual_len < 0)
+    {
+        return 0;
+    }
+
+    // Room for the terminator vsnprintf always writes
+    buffer_need(buffer, actual_len + 1);
+    vsnprintf(&buffer->data[buffer->len], actual_len + 1, fmt, args);
+    return actual_len;
+}
+
 void buffer_printf(struct buffer* buffer, const char* fmt, ...)
 {
     va_list args;
     va_start(args, fmt);
-    int index = buffer->len;
-    // Temporary, this is a limitation we are guessing the size is no more than 2048
-    int len = 2048;
-    buffer_extend(buffer, len);
-    int actual_len = vsnprintf(&buffer->data[index], len, fmt, args);
-    buffer->len += actual_len;
+    buffer->len += buffer_vprintf(buffer, fmt, args);
     va_end(args);
 }
 
@@ -45,12 +62,11 @@ void buffer_printf_no_terminator(struct buffer* buffer, const char* fmt, ...)
 {
     va_list args;
     va_start(args, fmt);
-    int index = buffer->len;
-    // Temporary, this is a limitation we are guessing the size is no more than 2048
-    int len = 2048;
-    buffer_extend(buffer, len);
-    int actual_len = vsnprintf(&buffer->data[index], len, fmt, args);
-    buffer->len += actual_len-1;
+    int actual_len = buffer_vprintf(buffer, fmt, args);
+    if (actual_len > 0)
+    {
+        buffer->len += actual_len-1;
+    }
     va_end(args);
 }
 
@@ -62,6 +78,20 @@ void buffer_write(struct buffer* buffer, char c)
     buffer->len++;
 }
 
+void buffer_write_bytes(struct buffer* buffer, const void* data, size_t len)
+{
+    buffer_need(buffer, len);
+
+    memcpy(&buffer->data[buffer->len], data, len);
+    buffer->len += len;
+}
+
+void buffer_clear(struct buffer* buffer)
+{
+    buffer->len = 0;
+    buffer->rindex = 0;
+}
+
 void* buffer_ptr(struct buffer* buffer)
 {
     return buffer->data;
@@ -0,0 +1,153 @@
+#include "intern.h"
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+uint32_t intern_hash(const char* str, size_t len)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+struct intern_table* intern_table_create(struct arena* arena)
+{
+    struct intern_table* table = calloc(sizeof(struct intern_table), 1);
+    table->capacity = INTERN_TABLE_INITIAL_CAPACITY;
+    table->entries = calloc(sizeof(struct intern_entry), table->capacity);
+    table->arena = arena;
+    return table;
+}
+
+void intern_table_free(struct intern_table* table)
+{
+    // The strings themselves belong to the arena
+    free(table->entries);
+    free(table);
+}
+
+static struct intern_entry* intern_find_slot(struct intern_entry* entries, size_t capacity, const char* str, size_t len, uint32_t hash)
+{
+    size_t mask = capacity - 1;
+    size_t index = hash & mask;
+    while (entries[index].str)
+    {
+        struct intern_entry* entry = &entries[index];
+        if (entry->hash == hash && entry->len == len && memcmp(entry->str, str, len) == 0)
+        {
+            break;
+        }
+        index = (index + 1) & mask;
+    }
+
+    return &entries[index];
+}
+
+static void intern_table_grow(struct intern_table* table)
+{
+    size_t capacity = table->capacity * 2;
+    struct intern_entry* entries = calloc(sizeof(struct intern_entry), capacity);
+    assert(entries);
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        struct intern_entry* entry = &table->entries[i];
+        if (entry->str)
+        {
+            *intern_find_slot(entries, capacity, entry->str, entry->len, entry->hash) = *entry;
+        }
+    }
+
+    free(table->entries);
+    table->entries = entries;
+    table->capacity = capacity;
+}
+
+const char* intern_lookup(struct intern_table* table, const char* str, size_t len)
+{
+    uint32_t hash = intern_hash(str, len);
+    return intern_find_slot(table->entries, table->capacity, str, len, hash)->str;
+}
+
+/**
+ * Returns the empty slot for a spelling that is not in the table yet, growing the table first if needed
+ */
+static struct intern_entry* intern_insert_slot(struct intern_table* table, const char* str, size_t len, uint32_t hash)
+{
+    // Keep the load factor under 70%
+    if ((table->count + 1) * 10 > table->capacity * 7)
+    {
+        intern_table_grow(table);
+    }
+    return intern_find_slot(table->entries, table->capacity, str, len, hash);
+}
+
+const char* intern(struct intern_table* table, const char* str, size_t len)
+{
+    uint32_t hash = intern_hash(str, len);
+    struct intern_entry* entry = intern_find_slot(table->entries, table->capacity, str, len, hash);
+    if (entry->str)
+    {
+        return entry->str;
+    }
+    entry = intern_insert_slot(table, str, len, hash);
+
+    struct intern_header* header = arena_alloc_aligned(table->arena, sizeof(struct intern_header) + len + 1, sizeof(uint32_t));
+    header->hash = hash;
+    header->len = len;
+    char* copy = (char*)(header + 1);
+    memcpy(copy, str, len);
+    copy[len] = 0x00;
+
+    entry->str = copy;
+    entry->hash = hash;
+    entry->len = len;
+    table->count++;
+    return copy;
+}
+
+const char* intern_adopt(struct intern_table* table, const char* interned)
+{
+    uint32_t hash = intern_string_hash(interned);
+    uint32_t len = intern_string_len(interned);
+    struct intern_entry* entry = intern_find_slot(table->entries, table->capacity, interned, len, hash);
+    if (entry->str)
+    {
+        return entry->str;
+    }
+    entry = intern_insert_slot(table, interned, len, hash);
+
+    entry->str = interned;
+    entry->hash = hash;
+    entry->len = len;
+    table->count++;
+    return interned;
+}
+
+size_t intern_slot(struct intern_table* table, const char* interned)
+{
+    size_t mask = table->capacity - 1;
+    size_t index = intern_string_hash(interned) & mask;
+    // Interned strings are unique, so the pointer alone identifies the entry
+    while (table->entries[index].str != interned)
+    {
+        assert(table->entries[index].str);
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+uint32_t intern_string_hash(const char* interned)
+{
+    return ((const struct intern_header*)interned)[-1].hash;
+}
+
+uint32_t intern_string_len(const char* interned)
+{
+    return ((const struct intern_header*)interned)[-1].len;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Initial slot count of the table, must be a power of two
+#define INTERN_TABLE_INITIAL_CAPACITY 1024
+
+struct arena;
+
+// Stored right in front of every interned string
+struct intern_header
+{
+    uint32_t hash;
+    uint32_t len;
+};
+
+struct intern_entry
+{
+    const char* str;
+    uint32_t hash;
+    uint32_t len;
+};
+
+// Open addressing hash set, every distinct spelling is stored once in the arena.
+// Two interned strings are equal if and only if their pointers are equal.
+struct intern_table
+{
+    struct intern_entry* entries;
+    size_t capacity;
+    size_t count;
+    struct arena* arena;
+};
+
+struct intern_table* intern_table_create(struct arena* arena);
+void intern_table_free(struct intern_table* table);
+
+uint32_t intern_hash(const char* str, size_t len);
+
+/**
+ * Returns the interned copy of str, inserting it if this spelling was not seen yet
+ */
+const char* intern(struct intern_table* table, const char* str, size_t len);
+
+/**
+ * Returns the interned copy of str or NULL if it was never interned
+ */
+const char* intern_lookup(struct intern_table* table, const char* str, size_t len);
+
+/**
+ * Adds a string that already carries its intern_header, without copying it.
+ * The memory has to outlive the table. Returns the interned pointer for this spelling
+ */
+const char* intern_adopt(struct intern_table* table, const char* interned);
+
+/**
+ * Returns the slot that holds an interned string. Slots are dense keys below
+ * table->capacity and stay valid until the next insertion
+ */
+size_t intern_slot(struct intern_table* table, const char* interned);
+
+/**
+ * Hash and length are stored right in front of every interned string
+ */
+uint32_t intern_string_hash(const char* interned);
+uint32_t intern_string_len(const char* interned);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "threadpool.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+
+struct threadpool_worker_arg
+{
+    struct threadpool* pool;
+    int index;
+};
+
+int threadpool_cpu_count()
+{
+    long total = sysconf(_SC_NPROCESSORS_ONLN);
+    return total > 0 ? (int)total : 1;
+}
+
+static void threadpool_deque_push(struct threadpool_deque* deque, struct threadpool_task* task)
+{
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail >= deque->capacity)
+    {
+        deque->capacity = deque->capacity ? deque->capacity * 2 : 16;
+        deque->tasks = realloc(deque->tasks, deque->capacity * sizeof(struct threadpool_task));
+        assert(deque->tasks);
+    }
+    deque->tasks[deque->tail++] = *task;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+/**
+ * Takes a task from the back (owner) or the front (thief) of the deque
+ */
+static bool threadpool_deque_take(struct threadpool_deque* deque, struct threadpool_task* task, bool steal)
+{
+    bool found = false;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->head < deque->tail)
+    {
+        *task = steal ? deque->tasks[deque->head++] : deque->tasks[--deque->tail];
+        found = true;
+        if (deque->head == deque->tail)
+        {
+            deque->head = 0;
+            deque->tail = 0;
+        }
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static bool threadpool_find_task(struct threadpool* pool, int index, struct threadpool_task* task)
+{
+    if (threadpool_deque_take(&pool->deques[index], task, false))
+    {
+        return true;
+    }
+
+    for (int i = 1; i < pool->total_workers; i++)
+    {
+        int victim = (index + i) % pool->total_workers;
+        if (threadpool_deque_take(&pool->deques[victim], task, true))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void threadpool_run_task(struct threadpool* pool, struct threadpool_task* task)
+{
+    task->function(task->arg);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->pending--;
+    if (pool->pending == 0)
+    {
+        pthread_cond_broadcast(&pool->work_done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void* threadpool_worker(void* ptr)
+{
+    struct threadpool_worker_arg* worker = ptr;
+    struct threadpool* pool = worker->pool;
+    int index = worker->index;
+    free(worker);
+
+    while (1)
+    {
+        struct threadpool_task task;
+        bool found = threadpool_find_task(pool, index, &task);
+        if (!found)
+        {
+            // Every deque is empty, sleep until something new is submitted.
+            // Submit pushes while holding the pool lock so the wakeup cannot be missed
+            pthread_mutex_lock(&pool->lock);
+            while (!pool->shutdown && !(found = threadpool_find_task(pool, index, &task)))
+            {
+                pthread_cond_wait(&pool->work_available, &pool->lock);
+            }
+            pthread_mutex_unlock(&pool->lock);
+        }
+
+        if (!found)
+        {
+            break;
+        }
+
+        threadpool_run_task(pool, &task);
+    }
+
+    return NULL;
+}
+
+struct threadpool* threadpool_create(int total_workers)
+{
+    if (total_workers <= 0)
+    {
+        total_workers = threadpool_cpu_count();
+    }
+
+    struct threadpool* pool = calloc(sizeof(struct threadpool), 1);
+    pool->total_workers = total_workers;
+    pool->threads = calloc(sizeof(pthread_t), total_workers);
+    pool->deques = calloc(sizeof(struct threadpool_deque), total_workers);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_available, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    for (int i = 0; i < total_workers; i++)
+    {
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+    }
+
+    for (int i = 0; i < total_workers; i++)
+    {
+        struct threadpool_worker_arg* worker = malloc(sizeof(struct threadpool_worker_arg));
+        worker->pool = pool;
+        worker->index = i;
+        pthread_create(&pool->threads[i], NULL, threadpool_worker, worker);
+    }
+
+    return pool;
+}
+
+void threadpool_submit(struct threadpool* pool, THREADPOOL_TASK_FUNCTION function, void* arg)
+{
+    struct threadpool_task task = {.function = function, .arg = arg};
+
+    pthread_mutex_lock(&pool->lock);
+    pool->pending++;
+    int index = pool->next_deque;
+    pool->next_deque = (pool->next_deque + 1) % pool->total_workers;
+    threadpool_deque_push(&pool->deques[index], &task);
+    pthread_cond_signal(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void threadpool_wait(struct threadpool* pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0)
+    {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void threadpool_free(struct threadpool* pool)
+{
+    threadpool_wait(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->total_workers; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].tasks);
+    }
+
+    pthread_cond_destroy(&pool->work_available);
+    pthread_cond_destroy(&pool->work_done);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->deques);
+    free(pool->threads);
+    free(pool);
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+typedef void (*THREADPOOL_TASK_FUNCTION)(void* arg);
+
+struct threadpool_task
+{
+    THREADPOOL_TASK_FUNCTION function;
+    void* arg;
+};
+
+// Each worker owns a deque. The owner takes work from the back,
+// idle workers steal from the front of the other deques.
+struct threadpool_deque
+{
+    pthread_mutex_t lock;
+    struct threadpool_task* tasks;
+    int head;
+    int tail;
+    int capacity;
+};
+
+struct threadpool
+{
+    pthread_t* threads;
+    struct threadpool_deque* deques;
+    int total_workers;
+    // Deque that receives the next submitted task
+    int next_deque;
+
+    pthread_mutex_t lock;
+    // Signalled when new work is submitted or the pool shuts down
+    pthread_cond_t work_available;
+    // Signalled when pending drops to zero
+    pthread_cond_t work_done;
+    // Tasks submitted but not finished yet
+    int pending;
+    bool shutdown;
+};
+
+/**
+ * Returns the number of online processors, at least 1
+ */
+int threadpool_cpu_count();
+
+struct threadpool* threadpool_create(int total_workers);
+void threadpool_submit(struct threadpool* pool, THREADPOOL_TASK_FUNCTION function, void* arg);
+
+/**
+ * Blocks until every submitted task has finished
+ */
+void threadpool_wait(struct threadpool* pool);
+
+/**
+ * Waits for the remaining tasks then joins the workers
+ */
+void threadpool_free(struct threadpool* pool);
+
+#endif
\ No newline at end of file
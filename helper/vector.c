@@ -50,9 +50,11 @@ struct vector *vector_clone(struct vector *vector)
     struct vector *new_vec = calloc(sizeof(struct vector), 1);
     memcpy(new_vec, vector, sizeof(struct vector));
     new_vec->data = new_data_address;
+    new_vec->mindex = vector->count + VECTOR_ELEMENT_INCREMENT;
 
-    // Saves are not cloned with vector_clone yet.
-    // assert(vector->saves == NULL);
+    // Saves are not cloned with vector_clone yet, give the clone its own empty stack
+    // so vector_free never releases the original's.
+    new_vec->saves = vector->saves ? vector_create_no_saves(sizeof(struct vector)) : NULL;
     return new_vec;
 }
 
@@ -65,6 +67,10 @@ struct vector *vector_create(size_t esize)
 
 void vector_free(struct vector *vector)
 {
+    if (vector->saves)
+    {
+        vector_free(vector->saves);
+    }
     free(vector->data);
     free(vector);
 }
@@ -74,6 +80,13 @@ int vector_current_index(struct vector *vector)
     return vector->rindex;
 }
 
+static void vector_set_capacity(struct vector *vector, int total_elements)
+{
+    vector->data = realloc(vector->data, total_elements * vector->esize);
+    assert(vector->data);
+    vector->mindex = total_elements;
+}
+
 void vector_resize_for_index(struct vector *vector, int start_index, int total_elements)
 {
     if (start_index + total_elements < vector->mindex)
@@ -82,9 +95,33 @@ void vector_resize_for_index(struct vector *vector, int start_index, int total_e
         return;
     }
 
-    vector->data = realloc(vector->data, ((start_index + total_elements + VECTOR_ELEMENT_INCREMENT) * vector->esize));
-    assert(vector->data);
-    vector->mindex = start_index + total_elements;
+    int new_mindex = vector->mindex * VECTOR_GROWTH_FACTOR;
+    if (new_mindex < start_index + total_elements + VECTOR_ELEMENT_INCREMENT)
+    {
+        new_mindex = start_index + total_elements + VECTOR_ELEMENT_INCREMENT;
+    }
+    vector_set_capacity(vector, new_mindex);
+}
+
+void vector_reserve(struct vector *vector, int total_elements)
+{
+    if (total_elements <= vector->mindex)
+    {
+        return;
+    }
+
+    vector_set_capacity(vector, total_elements);
+}
+
+void vector_shrink_to_fit(struct vector *vector)
+{
+    int total_elements = vector->rindex > 0 ? vector->rindex : 1;
+    if (total_elements == vector->mindex)
+    {
+        return;
+    }
+
+    vector_set_capacity(vector, total_elements);
 }
 
 void vector_resize_for(struct vector *vector, int total_elements)
@@ -235,16 +272,33 @@ void vector_pop_last_peek(struct vector* vector)
 
 void vector_push(struct vector *vector, void *elem)
 {
+    // Check before writing, a shrunk vector has no spare slot at the end
+    if (vector->rindex >= vector->mindex)
+    {
+        vector_resize(vector);
+    }
+
     void *ptr = vector_at(vector, vector->rindex);
     memcpy(ptr, elem, vector->esize);
 
     vector->rindex++;
     vector->count++;
+}
 
-    if (vector->rindex >= vector->mindex)
-    {
-        vector_resize(vector);
-    }
+void vector_push_multiple(struct vector *vector, const void *elems, int total)
+{
+    vector_resize_for(vector, total);
+    memcpy(vector_at(vector, vector->rindex), elems, total * vector->esize);
+
+    vector->rindex += total;
+    vector->count += total;
+}
+
+void vector_set_count(struct vector *vector, int total)
+{
+    vector_reserve(vector, total);
+    vector->rindex = total;
+    vector->count = total;
 }
 
 int vector_fread(struct vector *vector, int amount, FILE *fp)
@@ -281,10 +335,11 @@ int vector_elements_until_end(struct vector *vector, int index)
 
 void vector_shift_right_in_bounds_no_increment(struct vector *vector, int index, int amount)
 {
-    vector_resize_for_index(vector, index, amount);
+    // Every element up to rindex moves right by amount
+    vector_resize_for_index(vector, vector->rindex, amount);
     int eindex = (index + amount);
     size_t bytes_to_move = vector_elements_until_end(vector, index) * vector->esize;
-    memcpy(vector_at(vector, eindex), vector_at(vector, index), bytes_to_move);
+    memmove(vector_at(vector, eindex), vector_at(vector, index), bytes_to_move);
     memset(vector_at(vector, index), 0x00, amount * vector->esize);
 }
 
@@ -352,11 +407,27 @@ void vector_pop_at(struct vector *vector, int index)
     void *next_element_pos = dst_pos + vector->esize;
     void *end_pos = vector_data_end(vector);
     size_t total = (size_t)end_pos - (size_t)next_element_pos;
-    memcpy(dst_pos, next_element_pos, total);
+    memmove(dst_pos, next_element_pos, total);
     vector->count -= 1;
     vector->rindex -= 1;
 }
 
+void vector_erase_range(struct vector *vector, int index, int total)
+{
+    if (total <= 0)
+    {
+        return;
+    }
+
+    void *dst_pos = vector_at(vector, index);
+    void *next_element_pos = dst_pos + total * vector->esize;
+    void *end_pos = vector_data_end(vector);
+    size_t total_bytes = (size_t)end_pos - (size_t)next_element_pos;
+    memmove(dst_pos, next_element_pos, total_bytes);
+    vector->count -= total;
+    vector->rindex -= total;
+}
+
 void vector_peek_pop(struct vector *vector)
 {
     // Popping at a peek is an akward one
@@ -10,6 +10,9 @@
 // We want at least 20 vector element spaces in reserve before having
 // to reallocate memory again
 #define VECTOR_ELEMENT_INCREMENT 20
+// When we do reallocate the capacity grows by this factor so that
+// N pushes only cost O(N) element copies in total
+#define VECTOR_GROWTH_FACTOR 2
 
 enum
 {
@@ -23,6 +26,7 @@ struct vector
     // This index will then be incremented
     int pindex;
     int rindex;
+    // Total elements the data buffer can hold
     int mindex;
     int count;
     int flags;
@@ -62,6 +66,27 @@ void* vector_peek_ptr(struct vector* vector);
 void vector_set_peek_pointer(struct vector* vector, int index);
 void vector_set_peek_pointer_end(struct vector* vector);
 void vector_push(struct vector* vector, void* elem);
+
+/**
+ * Pushes total elements stored back to back at elems with a single copy
+ */
+void vector_push_multiple(struct vector* vector, const void* elems, int total);
+
+/**
+ * Sets the element count to total, growing the buffer when needed.
+ * Added elements are left uninitialized for the caller to fill in
+ */
+void vector_set_count(struct vector* vector, int total);
+
+/**
+ * Makes sure the vector can hold at least total_elements without reallocating
+ */
+void vector_reserve(struct vector* vector, int total_elements);
+
+/**
+ * Releases the unused capacity at the end of the vector
+ */
+void vector_shrink_to_fit(struct vector* vector);
 void vector_push_at(struct vector *vector, int index, void *ptr);
 void vector_pop(struct vector* vector);
 void vector_peek_pop(struct vector* vector);
@@ -110,6 +135,11 @@ int vector_pop_value(struct vector* vector, void* val);
 
 void vector_pop_at(struct vector *vector, int index);
 
+/**
+ * Removes total elements starting at index, the tail is moved down with a single memmove
+ */
+void vector_erase_range(struct vector *vector, int index, int total);
+
 /**
  * Decrements the peek pointer so that the next peek
  * will point at the last peeked token
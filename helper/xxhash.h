@@ -0,0 +1,12 @@
+#ifndef XXHASH_H
+#define XXHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * 64-bit xxHash (XXH64) of len bytes, fast enough to key caches on file contents
+ */
+uint64_t xxh64(const void* data, size_t len, uint64_t seed);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include "compiler.h"
+#include "helpers/vector.h"
+#include "helpers/buffer.h"
+#include "helpers/threadpool.h"
+
+/**
+ * 多线程一致性检查：同一组文件先用1个线程、再用N个线程做词法分析和语法分析，
+ * 逐个文件比较token和语法树的文本输出，不一致时输出差异位置，返回1
+ * 用法：jobs_check [-j workers] [-n rounds] [-p] [-e] file.c ... @response_file
+ *   -j N个线程的一轮使用的线程数，默认等于CPU核数
+ *   -n N个线程重复的轮数，默认3
+ *   -p 大文件切块，多个线程同时做词法分析，两轮都使用
+ *   -e 不生成注释token，两轮都使用
+ */
+
+struct check_job
+{
+    const char* filename;
+    int flags;
+    // token和语法树的文本输出
+    struct buffer* dump;
+};
+
+/**
+ * @brief 与compile_file相同的流程词法分析并语法分析一个文件，输出格式化到job->dump
+ *
+ * @param arg
+ */
+static void check_job_run(void* arg)
+{
+    struct check_job* job = arg;
+    job->dump = buffer_create();
+
+    struct compile_process* compiler = compile_process_create(job->filename, "/dev/null", job->flags);
+    if(!compiler){
+        buffer_printf(job->dump, "cannot open %s\n", job->filename);
+        return;
+    }
+
+    struct lex_process_functions* functions = compiler->cfile.data ? &compiler_mmap_lex_functions : &compiler_lex_functions;
+    struct lex_process* lex_process = lex_process_create(compiler, functions, NULL);
+    int res = 0;
+    if(job->flags & COMPILE_PROCESS_FLAG_PARALLEL_LEX){
+        res = lex_parallel(lex_process, 0);
+    }
+    else{
+        vector_reserve(lex_process->token_vec, compiler->cfile.size / LEX_ESTIMATED_BYTES_PER_TOKEN);
+        res = lex(lex_process);
+    }
+    if(res != LEXICAL_ANALYSISI_ALL_OK){
+        buffer_printf(job->dump, "lex failed\n");
+        lex_process_free(lex_process);
+        compile_process_free(compiler);
+        return;
+    }
+    gdb_format_lexer_token_vec(job->dump, lex_process);
+
+    compiler->token_vec = lex_process->token_vec;
+    if(parse(compiler) != PARSE_ALL_OK){
+        buffer_printf(job->dump, "parse failed\n");
+    }
+    else{
+        gdb_format_ast(job->dump, compiler);
+    }
+
+    lex_process_free(lex_process);
+    compile_process_free(compiler);
+}
+
+/**
+ * @brief 用total_workers个线程处理全部文件
+ *
+ * @param jobs
+ * @param total_jobs
+ * @param total_workers 0表示CPU核数
+ * @return int 实际的线程数
+ */
+static int check_run(struct check_job* jobs, int total_jobs, int total_workers)
+{
+    struct threadpool* pool = threadpool_create(total_workers);
+    for(int i = 0; i < total_jobs; i++){
+        threadpool_submit(pool, check_job_run, &jobs[i]);
+    }
+    total_workers = pool->total_workers;
+    threadpool_free(pool);
+    return total_workers;
+}
+
+/**
+ * @brief 比较两次输出，不一致时报告第一处不同所在的行
+ *
+ * @return true 一致
+ */
+static bool check_compare(const char* filename, struct buffer* expected, struct buffer* actual, int round)
+{
+    const char* a = buffer_ptr(expected);
+    const char* b = buffer_ptr(actual);
+    if(expected->len == actual->len && memcmp(a, b, expected->len) == 0){
+        return true;
+    }
+
+    int line = 1;
+    int i = 0;
+    while(i < expected->len && i < actual->len && a[i] == b[i]){
+        if('\n' == a[i]){
+            line++;
+        }
+        i++;
+    }
+    fprintf(stderr, "%s: round %d differs from the single worker output at dump line %d\n", filename, round, line);
+    return false;
+}
+
+static void check_free_dumps(struct check_job* jobs, int total_jobs)
+{
+    for(int i = 0; i < total_jobs; i++){
+        buffer_free(jobs[i].dump);
+        jobs[i].dump = NULL;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    struct vector* files = vector_create(sizeof(char*));
+    // 响应文件中读出的文件名，结束时释放
+    struct vector* names = vector_create(sizeof(char*));
+    int total_workers = 0;
+    int rounds = 3;
+    int flags = 0;
+    for(int i = 1; i < argc; i++){
+        if(S_EQ(argv[i], "-j") && i + 1 < argc){
+            total_workers = atoi(argv[++i]);
+        }
+        else if(S_EQ(argv[i], "-n") && i + 1 < argc){
+            rounds = atoi(argv[++i]);
+        }
+        else if(S_EQ(argv[i], "-p")){
+            flags |= COMPILE_PROCESS_FLAG_PARALLEL_LEX;
+        }
+        else if(S_EQ(argv[i], "-e")){
+            flags |= COMPILE_PROCESS_FLAG_ELIDE_TRIVIA;
+        }
+        else if('@' == argv[i][0]){
+            FILE* fp = fopen(argv[i] + 1, "r");
+            if(!fp){
+                fprintf(stderr, "Cannot open response file %s\n", argv[i] + 1);
+                return 1;
+            }
+            char name[4096];
+            while(fscanf(fp, "%4095s", name) == 1){
+                char* filename = strdup(name);
+                vector_push(files, &filename);
+                vector_push(names, &filename);
+            }
+            fclose(fp);
+        }
+        else{
+            vector_push(files, &argv[i]);
+        }
+    }
+    if(vector_empty(files)){
+        fprintf(stderr, "No input files\n");
+        vector_free(names);
+        vector_free(files);
+        return 1;
+    }
+
+    int total_jobs = vector_count(files);
+    struct check_job* jobs = calloc(total_jobs, sizeof(struct check_job));
+    for(int i = 0; i < total_jobs; i++){
+        jobs[i].filename = *(char**)vector_at(files, i);
+        jobs[i].flags = flags;
+    }
+
+    // 单线程的输出作为基准
+    check_run(jobs, total_jobs, 1);
+    struct buffer** expected = calloc(total_jobs, sizeof(struct buffer*));
+    for(int i = 0; i < total_jobs; i++){
+        expected[i] = jobs[i].dump;
+        jobs[i].dump = NULL;
+    }
+
+    int mismatched = 0;
+    for(int round = 1; round <= rounds; round++){
+        total_workers = check_run(jobs, total_jobs, total_workers);
+        for(int i = 0; i < total_jobs; i++){
+            if(!check_compare(jobs[i].filename, expected[i], jobs[i].dump, round)){
+                mismatched++;
+            }
+        }
+        check_free_dumps(jobs, total_jobs);
+    }
+    printf("%d files, 1 worker vs %d workers, %d rounds, %d mismatched\n", total_jobs, total_workers, rounds, mismatched);
+
+    for(int i = 0; i < total_jobs; i++){
+        buffer_free(expected[i]);
+    }
+    free(expected);
+    free(jobs);
+    for(int i = 0; i < vector_count(names); i++){
+        free(*(char**)vector_at(names, i));
+    }
+    vector_free(names);
+    vector_free(files);
+    return mismatched ? 1 : 0;
+}
@@ -0,0 +1,156 @@
+#include "compiler.h"
+
+/**
+ * 关键字完美哈希，参照gperf生成方式：
+ * hash = 长度 + asso[首字符] + asso[尾字符]，35个关键字互不冲突
+ * 命中槽位后再比较一次长度与字串即可确定是否为关键字
+ */
+#define KEYWORD_MIN_WORD_LENGTH 2
+#define KEYWORD_MAX_WORD_LENGTH 18
+#define KEYWORD_MAX_HASH_VALUE 60
+
+struct keyword_entry
+{
+    const char *name;
+    unsigned char len;
+    int keyword;
+};
+
+static const unsigned char keyword_asso_values[256] = {
+    ['_'] = 23,
+    ['a'] = 12,
+    ['b'] = 27,
+    ['c'] = 8,
+    ['d'] = 22,
+    ['e'] = 28,
+    ['f'] = 20,
+    ['g'] = 17,
+    ['h'] = 6,
+    ['i'] = 20,
+    ['k'] = 17,
+    ['l'] = 10,
+    ['m'] = 0,
+    ['n'] = 0,
+    ['o'] = 3,
+    ['r'] = 2,
+    ['s'] = 31,
+    ['t'] = 10,
+    ['u'] = 8,
+    ['v'] = 0,
+    ['w'] = 20,
+};
+
+static const struct keyword_entry keyword_wordlist[KEYWORD_MAX_HASH_VALUE + 1] = {
+    [8] = {"return", 6, KEYWORD_RETURN},
+    [12] = {"register", 8, KEYWORD_REGISTER},
+    [13] = {"union", 5, KEYWORD_UNION},
+    [14] = {"char", 4, KEYWORD_CHAR},
+    [19] = {"auto", 4, KEYWORD_AUTO},
+    [20] = {"restrict", 8, KEYWORD_RESTRICT},
+    [23] = {"const", 5, KEYWORD_CONST},
+    [24] = {"goto", 4, KEYWORD_GOTO},
+    [25] = {"for", 3, KEYWORD_FOR},
+    [26] = {"void", 4, KEYWORD_VOID},
+    [27] = {"do", 2, KEYWORD_DO},
+    [31] = {"long", 4, KEYWORD_LONG},
+    [32] = {"enum", 4, KEYWORD_ENUM},
+    [33] = {"int", 3, KEYWORD_INT},
+    [34] = {"extern", 6, KEYWORD_EXTERN},
+    [35] = {"float", 5, KEYWORD_FLOAT},
+    [36] = {"volatile", 8, KEYWORD_VOLATILE},
+    [37] = {"typedef", 7, KEYWORD_TYPEDEF},
+    [38] = {"unsigned", 8, KEYWORD_UNSIGNED},
+    [39] = {"default", 7, KEYWORD_DEFAULT},
+    [40] = {"case", 4, KEYWORD_CASE},
+    [42] = {"if", 2, KEYWORD_IF},
+    [43] = {"switch", 6, KEYWORD_SWITCH},
+    [44] = {"continue", 8, KEYWORD_CONTINUE},
+    [45] = {"static", 6, KEYWORD_STATIC},
+    [46] = {"short", 5, KEYWORD_SHORT},
+    [47] = {"struct", 6, KEYWORD_STRUCT},
+    [49] = {"break", 5, KEYWORD_BREAK},
+    [53] = {"while", 5, KEYWORD_WHILE},
+    [55] = {"include", 7, KEYWORD_INCLUDE},
+    [56] = {"double", 6, KEYWORD_DOUBLE},
+    [57] = {"sizeof", 6, KEYWORD_SIZEOF},
+    [58] = {"__ignore_typecheck", 18, KEYWORD_IGNORE_TYPECHECK},
+    [59] = {"signed", 6, KEYWORD_SIGNED},
+    [60] = {"else", 4, KEYWORD_ELSE},
+};
+
+static const char *const keyword_names[KEYWORD_COUNT] = {
+    [KEYWORD_VOID] = "void",
+    [KEYWORD_CHAR] = "char",
+    [KEYWORD_INT] = "int",
+    [KEYWORD_FLOAT] = "float",
+    [KEYWORD_DOUBLE] = "double",
+    [KEYWORD_SHORT] = "short",
+    [KEYWORD_LONG] = "long",
+    [KEYWORD_SIGNED] = "signed",
+    [KEYWORD_UNSIGNED] = "unsigned",
+    [KEYWORD_STRUCT] = "struct",
+    [KEYWORD_UNION] = "union",
+    [KEYWORD_ENUM] = "enum",
+    [KEYWORD_TYPEDEF] = "typedef",
+    [KEYWORD_SIZEOF] = "sizeof",
+    [KEYWORD_AUTO] = "auto",
+    [KEYWORD_STATIC] = "static",
+    [KEYWORD_REGISTER] = "register",
+    [KEYWORD_EXTERN] = "extern",
+    [KEYWORD_CONST] = "const",
+    [KEYWORD_VOLATILE] = "volatile",
+    [KEYWORD_RETURN] = "return",
+    [KEYWORD_CONTINUE] = "continue",
+    [KEYWORD_BREAK] = "break",
+    [KEYWORD_GOTO] = "goto",
+    [KEYWORD_IF] = "if",
+    [KEYWORD_ELSE] = "else",
+    [KEYWORD_SWITCH] = "switch",
+    [KEYWORD_CASE] = "case",
+    [KEYWORD_DEFAULT] = "default",
+    [KEYWORD_FOR] = "for",
+    [KEYWORD_DO] = "do",
+    [KEYWORD_WHILE] = "while",
+    [KEYWORD_IGNORE_TYPECHECK] = "__ignore_typecheck",
+    [KEYWORD_INCLUDE] = "include",
+    [KEYWORD_RESTRICT] = "restrict",
+};
+
+static unsigned int keyword_hash(const char *str, size_t len)
+{
+    return len + keyword_asso_values[(unsigned char)str[0]] + keyword_asso_values[(unsigned char)str[len - 1]];
+}
+
+/**
+ * @brief 查找关键字编号
+ * 
+ * @param str 不要求以0结尾
+ * @param len 
+ * @return int 关键字编号KEYWORD_XXX，不是关键字返回KEYWORD_NONE
+ */
+int keyword_lookup(const char *str, size_t len)
+{
+    if(len < KEYWORD_MIN_WORD_LENGTH || len > KEYWORD_MAX_WORD_LENGTH){
+        return KEYWORD_NONE;
+    }
+
+    unsigned int hash = keyword_hash(str, len);
+    if(hash > KEYWORD_MAX_HASH_VALUE){
+        return KEYWORD_NONE;
+    }
+
+    const struct keyword_entry *entry = &keyword_wordlist[hash];
+    if(entry->len != len || entry->name[0] != str[0] || memcmp(entry->name, str, len) != 0){
+        return KEYWORD_NONE;
+    }
+
+    return entry->keyword;
+}
+
+const char *keyword_name(int keyword)
+{
+    if(keyword < 0 || keyword >= KEYWORD_COUNT){
+        return NULL;
+    }
+    return keyword_names[keyword];
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef LEX_INPUT_H
+#define LEX_INPUT_H
+
+#include <assert.h>
+#include <stdio.h>
+#include "compiler.h"
+
+/**
+ * 各种输入方式的读字符原语，cprocess.c、lexer.c中的函数表与
+ * lexer.c按输入方式展开的词法分析器共用，展开后可以直接内联
+ */
+
+/*----------stdio stream-----------*/
+static inline char lex_input_stream_next(struct compile_process* compiler)
+{
+    //每次从fileStream读入1字符，一个文件只由一个线程读取，不必加锁
+    char c = getc_unlocked(compiler->cfile.fp);
+    if(EOF == c){
+        return c;
+    }
+    compiler->cfile.offset += 1;
+
+    //流无法预先扫描，读到换行时记录行首
+    if('\n' == c){
+        line_index_add_line(&compiler->lines, compiler->cfile.offset);
+    }
+
+    return c;
+}
+
+static inline char lex_input_stream_peek(struct compile_process* compiler)
+{
+    //从文件流中读一个后放回
+    char c = getc_unlocked(compiler->cfile.fp);
+    ungetc(c, compiler->cfile.fp);
+
+    return c;
+}
+
+static inline void lex_input_stream_push(struct compile_process* compiler, char c)
+{
+    ungetc(c, compiler->cfile.fp);
+    compiler->cfile.offset -= 1;
+}
+
+/*----------contiguous buffer: mapped file or caller's memory-----------*/
+static inline char lex_input_buffer_next(const char* data, size_t size, size_t* offset)
+{
+    if(*offset >= size){
+        return EOF;
+    }
+    return data[(*offset)++];
+}
+
+static inline char lex_input_buffer_peek(const char* data, size_t size, size_t offset)
+{
+    if(offset >= size){
+        return EOF;
+    }
+    return data[offset];
+}
+
+/**
+ * @brief 回退游标，只能退回刚读过的字符
+ */
+static inline void lex_input_buffer_push(const char* data, size_t* offset, char c)
+{
+    assert(*offset > 0 && data[*offset - 1] == c);
+    *offset -= 1;
+}
+
+static inline const char* lex_input_buffer_remaining(const char* data, size_t size, size_t offset, size_t* len)
+{
+    *len = size - offset;
+    return data + offset;
+}
+
+static inline void lex_input_buffer_skip(size_t size, size_t* offset, size_t len)
+{
+    assert(*offset + len <= size);
+    *offset += len;
+}
+
+#endif
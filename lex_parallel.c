@@ -0,0 +1,418 @@
+#include<stdlib.h>
+#include<string.h>
+#include "compiler.h"
+#include "helpers/arena.h"
+#include "helpers/intern.h"
+#include "helpers/threadpool.h"
+#include "helpers/vector.h"
+
+/**
+ * 单个大文件的并行词法分析：
+ * 1. 按大小均分，切点移到其后第一个不是续行的换行之后；各块假定从代码中开始，并行预扫描，
+ *    整体跳过字串、字符和注释，记下扫描停下的位置
+ * 2. 前一块扫描停下的位置恰好是切点时切点有效；否则切点落在字串或注释中，
+ *    从停下的位置顺序找下一个代码中的换行作为切点（很少发生）
+ * 3. 每块用各自的arena和驻留表并行分析，切点前的换行作为上下文
+ * 4. 顺序合并驻留表，由各块token数和括号增量算出起始下标和起点处的括号深度
+ * 5. 并行把token拷入token_vec并换成合并后的标识符，同时找出最外层括号，最后顺序拼接旁表
+ * 行列号由token偏移按需计算，与切块无关，无需修正；块内报错取块内lex_process的偏移，同样是源文件中的偏移
+ */
+
+struct lex_parallel_chunk
+{
+    // 源文件中[start, end)，start之前是代码中的换行
+    size_t start;
+    size_t end;
+    // 预扫描停下的位置，不小于end，此处位于代码中
+    size_t scan_end;
+
+    // 每块各自的arena和驻留表，合并后arena归源文件的compile_process所有
+    struct compile_process compiler;
+    struct lex_process* process;
+    // 括号增量
+    int paren_delta;
+
+    // 块内token为token_vec[skip, skip + count)，skip为1时开头是上下文token
+    int skip;
+    int count;
+    // 块内驻留表的槽位 -> 合并后的标识符
+    const char** identifiers;
+    // 合并后token_vec的数据，块内token从base开始
+    struct token* tokens;
+    int base;
+    // 起点处的括号深度
+    int depth;
+
+    // close：起点之前打开、在块内闭合的括号，只有last、end有效
+    bool has_close;
+    struct token_between_brackets close;
+    // 块内完整的括号
+    struct vector* groups;
+    // 到块尾仍未闭合的括号，只有first、start有效
+    bool has_open;
+    struct token_between_brackets open;
+    // 出现了没有对应'('的')'，error_offset为第一个这样的')'在源文件中的偏移
+    bool error;
+    size_t error_offset;
+};
+
+static bool lex_parallel_is_identifier_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+/**
+ * @brief 同token_make_operator_or_string：'<'前的token是include关键字时读作字串，中间只能有空格
+ *
+ * @param data
+ * @param pos '<'的位置
+ * @return true
+ * @return false
+ */
+static bool lex_parallel_is_include_string(const char* data, size_t pos)
+{
+    while(pos > 0 && (' ' == data[pos - 1] || '\t' == data[pos - 1])){
+        pos--;
+    }
+    return pos >= 7 && memcmp(data + pos - 7, "include", 7) == 0 &&
+           (pos == 7 || !lex_parallel_is_identifier_char(data[pos - 8]));
+}
+
+/**
+ * @brief 跳过pos处开始的字串、字符或注释，规则与词法分析器相同，可能越过块尾
+ *
+ * @param data
+ * @param size
+ * @param pos lex_scan_code停下的位置
+ * @return size_t 跳过后的位置
+ */
+static size_t lex_parallel_skip(const char* data, size_t size, size_t pos)
+{
+    const char* p = data + pos;
+    size_t len = size - pos;
+    const char* end = NULL;
+    switch(*p){
+        case '"':
+            // '\\'只被丢弃，不影响字串结束，下一个'"'就是结尾
+            end = memchr(p + 1, '"', len - 1);
+            return end ? (size_t)(end - data) + 1 : size;
+
+        case '\'':
+            // 'c'或'\c'，长度固定
+            len = len > 1 && '\\' == p[1] ? 4 : 3;
+            return pos + len < size ? pos + len : size;
+
+        case '/':
+            if(len > 1 && '/' == p[1]){
+                // 换行本身是token，停在换行上
+                return pos + 2 + lex_scan_line(p + 2, len - 2);
+            }
+            if(len > 1 && '*' == p[1]){
+                size_t n = lex_scan_comment_end(p + 2, len - 2);
+                return n == len - 2 ? size : pos + 2 + n + 2;
+            }
+            return pos + 1;
+
+        default:
+            if(lex_parallel_is_include_string(data, pos)){
+                end = memchr(p + 1, '>', len - 1);
+                return end ? (size_t)(end - data) + 1 : size;
+            }
+            return pos + 1;
+    }
+}
+
+/**
+ * @brief [from, to)中第一个不是续行的换行
+ * 省略换行时续行不结束预处理指令，块开头无从得知，不能作为切点
+ *
+ * @param data
+ * @param from
+ * @param to
+ * @return const char* 找不到时返回NULL
+ */
+static const char* lex_parallel_find_cut(const char* data, size_t from, size_t to)
+{
+    const char* nl = memchr(data + from, '\n', to - from);
+    while(nl && nl > data && '\\' == nl[-1]){
+        nl = memchr(nl + 1, '\n', data + to - nl - 1);
+    }
+    return nl;
+}
+
+/**
+ * @brief 从代码中的start预扫描到end
+ *
+ * @param data
+ * @param size
+ * @param start
+ * @param end
+ * @param newline 为true时在第一个代码中不是续行的换行之后停下
+ * @return size_t 停下的位置，此处位于代码中，跳过跨块的字串或注释时会越过end
+ */
+static size_t lex_parallel_scan(const char* data, size_t size, size_t start, size_t end, bool newline)
+{
+    size_t pos = start;
+    while(pos < end){
+        size_t n = lex_scan_code(data + pos, end - pos);
+        const char* nl = newline ? lex_parallel_find_cut(data, pos, pos + n) : NULL;
+        if(nl){
+            return nl - data + 1;
+        }
+
+        pos += n;
+        if(pos < end){
+            pos = lex_parallel_skip(data, size, pos);
+        }
+    }
+    return pos;
+}
+
+static void lex_parallel_scan_chunk(void* arg)
+{
+    struct lex_parallel_chunk* chunk = arg;
+    chunk->scan_end = lex_parallel_scan(chunk->compiler.cfile.data, chunk->compiler.cfile.size, chunk->start, chunk->end, false);
+}
+
+static void lex_parallel_lex_chunk(void* arg)
+{
+    struct lex_parallel_chunk* chunk = arg;
+    chunk->compiler.arena = arena_create();
+    chunk->compiler.interns = intern_table_create(chunk->compiler.arena);
+
+    chunk->process = lex_process_create_for_memory(&chunk->compiler, chunk->compiler.cfile.data, chunk->end);
+    chunk->process->memory.offset = chunk->start;
+    chunk->process->offset = chunk->start;
+    vector_reserve(chunk->process->token_vec, (chunk->end - chunk->start) / LEX_ESTIMATED_BYTES_PER_TOKEN);
+
+    // 切点前是换行token
+    struct token context = {.type = TOKEN_TYPE_NEWLINE, .offset = chunk->start - 1};
+    lex_chunk(chunk->process, chunk->start > 0 ? &context : NULL);
+
+    struct token* tokens = vector_data_ptr(chunk->process->token_vec);
+    for(int i = 0; i < vector_count(chunk->process->token_vec); i++){
+        chunk->paren_delta += lex_token_paren_delta(&tokens[i]);
+    }
+}
+
+static void lex_parallel_copy_chunk(void* arg)
+{
+    struct lex_parallel_chunk* chunk = arg;
+    struct intern_table* interns = chunk->compiler.interns;
+    struct token* tokens = (struct token*)vector_data_ptr(chunk->process->token_vec) + chunk->skip;
+    int depth = chunk->depth;
+    for(int i = 0; i < chunk->count; i++){
+        struct token token = tokens[i];
+        if(TOKEN_TYPE_IDENTIFIER == token.type){
+            token.sval = chunk->identifiers[intern_slot(interns, token.sval)];
+        }
+        chunk->tokens[chunk->base + i] = token;
+
+        // 同lex_new_expression、lex_finish_expression，只记录最外层括号
+        int index = chunk->base + i;
+        int paren = lex_token_paren_delta(&token);
+        if(paren > 0 && 0 == depth++){
+            chunk->has_open = true;
+            chunk->open.first = index + 1;
+            chunk->open.start = token.offset + 1;
+        }
+        else if(paren < 0 && depth <= 0){
+            if(!chunk->error){
+                chunk->error = true;
+                chunk->error_offset = token.offset;
+            }
+        }
+        else if(paren < 0 && 0 == --depth){
+            if(!chunk->has_open){
+                chunk->has_close = true;
+                chunk->close.last = index - 1;
+                chunk->close.end = token.offset;
+                continue;
+            }
+
+            chunk->has_open = false;
+            chunk->open.last = index - 1;
+            chunk->open.end = token.offset;
+            if(chunk->open.first <= chunk->open.last){
+                vector_push(chunk->groups, &chunk->open);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 切分源文件，预扫描后只保留有效切点
+ *
+ * @param compiler
+ * @param total_chunks 期望的块数
+ * @param pool
+ * @return struct vector* 元素为struct lex_parallel_chunk
+ */
+static struct vector* lex_parallel_split(struct compile_process* compiler, int total_chunks, struct threadpool* pool)
+{
+    const char* data = compiler->cfile.data;
+    size_t size = compiler->cfile.size;
+    struct vector* chunks = vector_create(sizeof(struct lex_parallel_chunk));
+    vector_reserve(chunks, total_chunks);
+    size_t start = 0;
+    for(int i = 1; i <= total_chunks && start < size; i++){
+        size_t end = size;
+        if(i < total_chunks){
+            // 超长的行可能已越过均分点
+            size_t at = size / total_chunks * i;
+            if(at < start){
+                at = start;
+            }
+            const char* nl = lex_parallel_find_cut(data, at, size);
+            end = nl ? (size_t)(nl - data) + 1 : size;
+        }
+        if(end <= start){
+            continue;
+        }
+
+        struct lex_parallel_chunk chunk = {.start = start, .end = end, .compiler = *compiler};
+        vector_push(chunks, &chunk);
+        start = end;
+    }
+
+    struct lex_parallel_chunk* all = vector_data_ptr(chunks);
+    for(int i = 0; i < vector_count(chunks); i++){
+        threadpool_submit(pool, lex_parallel_scan_chunk, &all[i]);
+    }
+    threadpool_wait(pool);
+
+    // 0号块从文件开头扫描，结果可信；之后每块都要看前一块停在哪里
+    int total = 1;
+    size_t pos = all[0].scan_end;
+    for(int i = 1; i < vector_count(chunks); i++){
+        struct lex_parallel_chunk chunk = all[i];
+        if(pos != chunk.start){
+            // 切点落在字串或注释中，往后找真正的切点，找不到时并入前一块
+            chunk.start = lex_parallel_scan(data, size, pos, size, true);
+            if(chunk.start >= chunk.end){
+                pos = chunk.start;
+                continue;
+            }
+            chunk.scan_end = lex_parallel_scan(data, size, chunk.start, chunk.end, false);
+        }
+
+        all[total - 1].end = chunk.start;
+        all[total++] = chunk;
+        pos = chunk.scan_end;
+    }
+    all[total - 1].end = size;
+    vector_set_count(chunks, total);
+    return chunks;
+}
+
+int lex_parallel(struct lex_process* process, int total_workers)
+{
+    struct compile_process* compiler = process->compiler;
+    size_t size = compiler->cfile.size;
+    if(total_workers <= 0){
+        total_workers = threadpool_cpu_count();
+    }
+    int total_chunks = total_workers * LEX_PARALLEL_CHUNKS_PER_WORKER;
+    if(size / LEX_PARALLEL_MIN_CHUNK_SIZE < (size_t)total_chunks){
+        total_chunks = size / LEX_PARALLEL_MIN_CHUNK_SIZE;
+    }
+
+    // 流式输入或文件太小时顺序分析
+    if(!compiler->cfile.data || total_workers < 2 || total_chunks < 2){
+        vector_reserve(process->token_vec, size / LEX_ESTIMATED_BYTES_PER_TOKEN);
+        return lex(process);
+    }
+
+    struct threadpool* pool = threadpool_create(total_workers);
+    struct vector* chunk_vec = lex_parallel_split(compiler, total_chunks, pool);
+    struct lex_parallel_chunk* chunks = vector_data_ptr(chunk_vec);
+    total_chunks = vector_count(chunk_vec);
+    for(int i = 0; i < total_chunks; i++){
+        threadpool_submit(pool, lex_parallel_lex_chunk, &chunks[i]);
+    }
+    threadpool_wait(pool);
+
+    // 块开头的上下文只带回块首空白的标记，记在前一块最后的token上
+    for(int i = 0; i < total_chunks; i++){
+        struct lex_parallel_chunk* chunk = &chunks[i];
+        struct vector* token_vec = chunk->process->token_vec;
+        if(i > 0){
+            struct lex_parallel_chunk* prev = &chunks[i - 1];
+            struct token* first = vector_at(token_vec, 0);
+            struct token* last = vector_at(prev->process->token_vec, prev->skip + prev->count - 1);
+            last->flags |= first->flags;
+            chunk->skip = 1;
+        }
+        chunk->count = vector_count(token_vec) - chunk->skip;
+
+        // 按块的顺序合并，同一拼写保留最先出现的那份
+        struct intern_table* interns = chunk->compiler.interns;
+        chunk->identifiers = malloc(interns->capacity * sizeof(const char*));
+        for(size_t slot = 0; slot < interns->capacity; slot++){
+            if(interns->entries[slot].str){
+                chunk->identifiers[slot] = intern_adopt(compiler->interns, interns->entries[slot].str);
+            }
+        }
+        chunk->groups = vector_create(sizeof(struct token_between_brackets));
+    }
+
+    int total_tokens = 0;
+    int depth = 0;
+    for(int i = 0; i < total_chunks; i++){
+        chunks[i].base = total_tokens;
+        chunks[i].depth = depth;
+        total_tokens += chunks[i].count;
+        depth += chunks[i].paren_delta;
+    }
+
+    vector_set_count(process->token_vec, total_tokens);
+    for(int i = 0; i < total_chunks; i++){
+        chunks[i].tokens = vector_data_ptr(process->token_vec);
+        threadpool_submit(pool, lex_parallel_copy_chunk, &chunks[i]);
+    }
+    threadpool_wait(pool);
+    threadpool_free(pool);
+
+    // 拼接括号旁表，跨块的括号由打开它的块与闭合它的块组成
+    struct token_between_brackets open = {};
+    bool has_open = false;
+    for(int i = 0; i < total_chunks; i++){
+        struct lex_parallel_chunk* chunk = &chunks[i];
+        if(chunk->error){
+            compiler_error_pos(compile_process_pos(compiler, chunk->error_offset), "You closed an expression that you never opened.\n");
+        }
+        if(chunk->has_close){
+            open.last = chunk->close.last;
+            open.end = chunk->close.end;
+            if(open.first <= open.last){
+                vector_push(process->between_brackets_vec, &open);
+            }
+            has_open = false;
+        }
+        vector_push_multiple(process->between_brackets_vec, vector_data_ptr(chunk->groups), vector_count(chunk->groups));
+        if(chunk->has_open){
+            open = chunk->open;
+            has_open = true;
+        }
+
+        lex_process_free(chunk->process);
+        intern_table_free(chunk->compiler.interns);
+        arena_adopt(compiler->arena, chunk->compiler.arena);
+        free(chunk->identifiers);
+        vector_free(chunk->groups);
+    }
+
+    // 未闭合的括号一直延续到输入结尾
+    if(has_open){
+        open.last = total_tokens - 1;
+        open.end = size;
+        if(open.first <= open.last){
+            vector_push(process->between_brackets_vec, &open);
+        }
+    }
+
+    process->pos.filename = compiler->cfile.abs_path;
+    process->offset = size;
+    vector_free(chunk_vec);
+    return LEXICAL_ANALYSISI_ALL_OK;
+}
@@ -1,5 +1,6 @@
 #include "compiler.h"
 #include"helpers/vector.h"
+#include"helpers/buffer.h"
 #include<stdlib.h>
 
 struct lex_process* lex_process_create(struct compile_process* compiler, struct lex_process_functions* functions, void* private)
@@ -11,15 +12,35 @@ struct lex_process* lex_process_create(struct compile_process* compiler, struct
     process->compiler = compiler;
     process->functions = functions;
     process->private = private;
-    process->pos.line = 1;
-    process->pos.col = 1;
+    process->token_buffer = buffer_create();
+    process->between_brackets_vec = vector_create(sizeof(struct token_between_brackets));
 
     return process;
 }
 
+struct lex_process* lex_process_create_for_memory(struct compile_process* compiler, const char* data, size_t size)
+{
+    struct lex_process* process = lex_process_create(compiler, &lexer_memory_functions, NULL);
+    process->memory.data = data;
+    process->memory.size = size;
+    process->private = &process->memory;
+    return process;
+}
+
 void lex_process_free(struct lex_process* process)
 {
     vector_free(process->token_vec);
+    buffer_free(process->token_buffer);
+    vector_free(process->between_brackets_vec);
+    if(process->ring){
+        free(process->ring->tokens);
+        vector_free(process->ring->saves);
+        free(process->ring);
+    }
+    if(process->lines){
+        line_index_free(process->lines);
+        free(process->lines);
+    }
     free(process);
 }
 
@@ -31,4 +52,112 @@ void* lex_process_private(struct lex_process* process)
 struct vector* lex_process_vector(struct lex_process* process)
 {
     return process->token_vec;
+}
+
+/**
+ * @brief 输入中offset处的位置，输入不是compiler的源文件时使用process自己的行首索引
+ * 
+ * @param process 
+ * @param offset 
+ * @return struct pos 
+ */
+struct pos lex_process_pos(struct lex_process* process, size_t offset)
+{
+    if(!process->lines){
+        return compile_process_pos(process->compiler, offset);
+    }
+
+    struct pos pos = line_index_pos(process->lines, offset);
+    pos.filename = process->pos.filename;
+    return pos;
+}
+
+/**
+ * @brief 查询token_vec中第index个token的位置，由token的偏移按需计算
+ * 
+ * @param process 
+ * @param index 
+ * @return struct pos 
+ */
+struct pos lex_process_token_pos(struct lex_process* process, int index)
+{
+    return lex_process_pos(process, lex_process_token_offset(process, index));
+}
+
+/**
+ * @brief token_vec中第index个token的偏移，计入lex_relex延后的平移
+ * 
+ * @param process 
+ * @param index 
+ * @return size_t 
+ */
+size_t lex_process_token_offset(struct lex_process* process, int index)
+{
+    struct token* token = vector_at(process->token_vec, index);
+    if(index < process->shift.token_from){
+        return token->offset;
+    }
+    // 按uint32_t回绕，存放值可能小于平移量
+    return (uint32_t)(token->offset + (uint32_t)process->shift.offset);
+}
+
+/**
+ * @brief 旁表中第group个元素，计入lex_relex延后的平移
+ * 
+ * @param process 
+ * @param group 
+ * @return struct token_between_brackets 
+ */
+struct token_between_brackets lex_process_brackets_at(struct lex_process* process, int group)
+{
+    struct token_between_brackets brackets = *(struct token_between_brackets*)vector_at(process->between_brackets_vec, group);
+    if(group >= process->shift.bracket_from){
+        brackets.first += process->shift.count;
+        brackets.last += process->shift.count;
+        brackets.start += (uint32_t)process->shift.bracket_offset;
+        brackets.end += (uint32_t)process->shift.bracket_offset;
+    }
+    return brackets;
+}
+
+/**
+ * @brief 查询token_vec中第index个token所在的最外层括号，旁表按first升序，二分查找
+ * 
+ * @param process 
+ * @param index 
+ * @param brackets 括号内源码为[start, end)
+ * @return true 在括号内，结果写入brackets
+ */
+bool lex_process_token_between_brackets(struct lex_process* process, int index, struct token_between_brackets* brackets)
+{
+    int low = 0;
+    int high = vector_count(process->between_brackets_vec) - 1;
+    while(low <= high){
+        int mid = (low + high) / 2;
+        struct token_between_brackets entry = lex_process_brackets_at(process, mid);
+        if(entry.first <= index && index <= entry.last){
+            *brackets = entry;
+            return true;
+        }
+        else if(entry.last < index){
+            low = mid + 1;
+        }
+        else{
+            high = mid - 1;
+        }
+    }
+    return false;
+}
+
+void lex_process_apply_shift(struct lex_process* process)
+{
+    for(int i = process->shift.token_from; i < vector_count(process->token_vec); i++){
+        struct token* token = vector_at(process->token_vec, i);
+        token->offset = lex_process_token_offset(process, i);
+    }
+    for(int i = process->shift.bracket_from; i < vector_count(process->between_brackets_vec); i++){
+        struct token_between_brackets* entry = vector_at(process->between_brackets_vec, i);
+        *entry = lex_process_brackets_at(process, i);
+    }
+    memset(&process->shift, 0, sizeof(process->shift));
 }
\ No newline at end of file
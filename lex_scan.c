@@ -0,0 +1,184 @@
+#include "compiler.h"
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * 连续内存输入的批量扫描：一次比较16（SSE2）或32（AVX2）字节，
+ * 找到第一个不满足条件的字符，剩余不足一个向量宽度的部分逐字符处理
+ * 所有函数都返回从p开始满足条件的字节数，不会越过len
+ */
+
+static bool lex_scan_is_identifier_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+#if defined(__AVX2__)
+#define LEX_SCAN_WIDTH 32
+typedef __m256i lex_scan_vector;
+#define lex_scan_load(p) _mm256_loadu_si256((const __m256i *)(p))
+#define lex_scan_set1(c) _mm256_set1_epi8(c)
+#define lex_scan_eq(a, b) _mm256_cmpeq_epi8(a, b)
+#define lex_scan_gt(a, b) _mm256_cmpgt_epi8(a, b)
+#define lex_scan_and(a, b) _mm256_and_si256(a, b)
+#define lex_scan_or(a, b) _mm256_or_si256(a, b)
+#define lex_scan_mask(v) ((uint32_t)_mm256_movemask_epi8(v))
+#define LEX_SCAN_FULL_MASK 0xFFFFFFFFu
+#elif defined(__SSE2__)
+#define LEX_SCAN_WIDTH 16
+typedef __m128i lex_scan_vector;
+#define lex_scan_load(p) _mm_loadu_si128((const __m128i *)(p))
+#define lex_scan_set1(c) _mm_set1_epi8(c)
+#define lex_scan_eq(a, b) _mm_cmpeq_epi8(a, b)
+#define lex_scan_gt(a, b) _mm_cmpgt_epi8(a, b)
+#define lex_scan_and(a, b) _mm_and_si128(a, b)
+#define lex_scan_or(a, b) _mm_or_si128(a, b)
+#define lex_scan_mask(v) ((uint32_t)_mm_movemask_epi8(v))
+#define LEX_SCAN_FULL_MASK 0xFFFFu
+#endif
+
+#ifdef LEX_SCAN_WIDTH
+// 有符号比较，>=0x80的字节为负数，不会落在ASCII区间内
+static inline lex_scan_vector lex_scan_in_range(lex_scan_vector v, char low, char high)
+{
+    return lex_scan_and(lex_scan_gt(v, lex_scan_set1(low - 1)), lex_scan_gt(lex_scan_set1(high + 1), v));
+}
+#endif
+
+size_t lex_scan_identifier(const char *p, size_t len)
+{
+    size_t i = 0;
+#ifdef LEX_SCAN_WIDTH
+    for(; i + LEX_SCAN_WIDTH <= len; i += LEX_SCAN_WIDTH){
+        lex_scan_vector v = lex_scan_load(p + i);
+        lex_scan_vector ok = lex_scan_or(lex_scan_or(lex_scan_in_range(v, 'a', 'z'), lex_scan_in_range(v, 'A', 'Z')),
+                                         lex_scan_or(lex_scan_in_range(v, '0', '9'), lex_scan_eq(v, lex_scan_set1('_'))));
+        uint32_t stop = ~lex_scan_mask(ok) & LEX_SCAN_FULL_MASK;
+        if(stop){
+            return i + __builtin_ctz(stop);
+        }
+    }
+#endif
+    while(i < len && lex_scan_is_identifier_char(p[i])){
+        i++;
+    }
+    return i;
+}
+
+size_t lex_scan_digits(const char *p, size_t len)
+{
+    size_t i = 0;
+#ifdef LEX_SCAN_WIDTH
+    for(; i + LEX_SCAN_WIDTH <= len; i += LEX_SCAN_WIDTH){
+        lex_scan_vector v = lex_scan_load(p + i);
+        uint32_t stop = ~lex_scan_mask(lex_scan_in_range(v, '0', '9')) & LEX_SCAN_FULL_MASK;
+        if(stop){
+            return i + __builtin_ctz(stop);
+        }
+    }
+#endif
+    while(i < len && p[i] >= '0' && p[i] <= '9'){
+        i++;
+    }
+    return i;
+}
+
+/**
+ * @brief 空格和制表符连续出现的长度，用于一次跳过缩进、对齐用的空白
+ */
+size_t lex_scan_blank(const char *p, size_t len)
+{
+    size_t i = 0;
+#ifdef LEX_SCAN_WIDTH
+    const lex_scan_vector space = lex_scan_set1(' ');
+    const lex_scan_vector tab = lex_scan_set1('\t');
+    for(; i + LEX_SCAN_WIDTH <= len; i += LEX_SCAN_WIDTH){
+        lex_scan_vector v = lex_scan_load(p + i);
+        uint32_t stop = ~lex_scan_mask(lex_scan_or(lex_scan_eq(v, space), lex_scan_eq(v, tab))) & LEX_SCAN_FULL_MASK;
+        if(stop){
+            return i + __builtin_ctz(stop);
+        }
+    }
+#endif
+    while(i < len && (p[i] == ' ' || p[i] == '\t')){
+        i++;
+    }
+    return i;
+}
+
+/**
+ * @brief 单行注释内容的长度，到换行符为止（不含换行符）
+ */
+size_t lex_scan_line(const char *p, size_t len)
+{
+    size_t i = 0;
+#ifdef LEX_SCAN_WIDTH
+    const lex_scan_vector newline = lex_scan_set1('\n');
+    for(; i + LEX_SCAN_WIDTH <= len; i += LEX_SCAN_WIDTH){
+        uint32_t stop = lex_scan_mask(lex_scan_eq(lex_scan_load(p + i), newline));
+        if(stop){
+            return i + __builtin_ctz(stop);
+        }
+    }
+#endif
+    while(i < len && p[i] != '\n'){
+        i++;
+    }
+    return i;
+}
+
+/**
+ * @brief 多行注释内容的长度，即"*\/"的位置，没有结束符时返回len
+ */
+size_t lex_scan_comment_end(const char *p, size_t len)
+{
+    size_t i = 0;
+#ifdef LEX_SCAN_WIDTH
+    const lex_scan_vector star = lex_scan_set1('*');
+    const lex_scan_vector slash = lex_scan_set1('/');
+    // 同时比较p[i]=='*'与p[i+1]=='/'
+    for(; i + LEX_SCAN_WIDTH + 1 <= len; i += LEX_SCAN_WIDTH){
+        lex_scan_vector stars = lex_scan_eq(lex_scan_load(p + i), star);
+        lex_scan_vector slashes = lex_scan_eq(lex_scan_load(p + i + 1), slash);
+        uint32_t stop = lex_scan_mask(lex_scan_and(stars, slashes));
+        if(stop){
+            return i + __builtin_ctz(stop);
+        }
+    }
+#endif
+    for(; i + 1 < len; i++){
+        if(p[i] == '*' && p[i + 1] == '/'){
+            return i;
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief 预扫描代码时可以跳过的长度，到第一个可能开始字串、字符、注释
+ * 或#include<...>的字符为止，即'"'、'\''、'/'、'<'
+ */
+size_t lex_scan_code(const char *p, size_t len)
+{
+    size_t i = 0;
+#ifdef LEX_SCAN_WIDTH
+    const lex_scan_vector quote = lex_scan_set1('"');
+    const lex_scan_vector single_quote = lex_scan_set1('\'');
+    const lex_scan_vector slash = lex_scan_set1('/');
+    const lex_scan_vector less = lex_scan_set1('<');
+    for(; i + LEX_SCAN_WIDTH <= len; i += LEX_SCAN_WIDTH){
+        lex_scan_vector v = lex_scan_load(p + i);
+        lex_scan_vector hit = lex_scan_or(lex_scan_or(lex_scan_eq(v, quote), lex_scan_eq(v, single_quote)),
+                                          lex_scan_or(lex_scan_eq(v, slash), lex_scan_eq(v, less)));
+        uint32_t stop = lex_scan_mask(hit);
+        if(stop){
+            return i + __builtin_ctz(stop);
+        }
+    }
+#endif
+    while(i < len && p[i] != '"' && p[i] != '\'' && p[i] != '/' && p[i] != '<'){
+        i++;
+    }
+    return i;
+}
\ No newline at end of file
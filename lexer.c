@@ -1,451 +1,314 @@
 #include <assert.h>
 #include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "compiler.h"
+#include "lex_input.h"
+#include "helpers/arena.h"
 #include "helpers/buffer.h"
+#include "helpers/intern.h"
 #include "helpers/vector.h"
 
-#define LEX_GETC_IF(buffer, c, exp)     \
-  for (c = peekc(); exp; c = peekc()) { \
-    buffer_write(buffer, c);            \
-    nextc();                            \
+// 所有状态都保存在process中，不同的lex_process可在不同线程中同时分析
+#define LEX_GETC_IF(process, buffer, c, exp)              \
+  for (c = peekc(process); exp; c = peekc(process)) { \
+    buffer_write(buffer, c);                          \
+    nextc(process);                                   \
   }
 
-struct token *read_next_token();
-bool lex_is_in_expression();
-
-static struct lex_process *lex_process;
-static struct token tmp_token;
-
-static char peekc() { return lex_process->functions->peek_char(lex_process); }
-
-static void pushc(char c) { lex_process->functions->push_char(lex_process, c); }
+struct token *read_next_token(struct lex_process *process);
+bool lex_is_in_expression(struct lex_process *process);
 
 /**
- * @brief 从文件中读下一个
- *
- * @return char
+ * @brief 报告当前读到的位置并退出
+ * 位置取process自己的偏移而不是compiler的读取游标，内存中的源码、切块分析时两者不同
  */
-static char nextc() {
-  char c = lex_process->functions->next_char(lex_process);
-  // 读一个，列+1
-  if (lex_is_in_expression()) {
-    buffer_write(lex_process->parentheses_buffer, c);
+static void lexer_error(struct lex_process *process, const char *msg, ...) {
+  char message[256];
+  va_list args;
+  va_start(args, msg);
+  vsnprintf(message, sizeof(message), msg, args);
+  va_end(args);
+
+  // 内存中的源码不是compiler的源文件时偏移相对于这段源码，行首索引只在报错时建立
+  struct lex_memory_source *memory = &process->memory;
+  if (!process->lines && memory == process->private &&
+      memory->data != process->compiler->cfile.data) {
+    process->lines = calloc(1, sizeof(struct line_index));
+    line_index_init(process->lines);
+    line_index_build(process->lines, memory->data, memory->size);
   }
-
-  lex_process->pos.col += 1;
-  if ('\n' == c) {
-    lex_process->pos.col = 1;
-    lex_process->pos.line += 1;
-  }
-
-  return c;
+  compiler_error_pos(lex_process_pos(process, process->offset), "%s", message);
 }
 
-static char assert_next_char(char c) {
-  char next_c = nextc();
-  assert(c == next_c);
-  return next_c;
+/**
+ * @brief 取出清空后的临时缓冲，token内容先写入这里
+ *
+ * @return struct buffer*
+ */
+static struct buffer *lexer_token_buffer(struct lex_process *process) {
+  buffer_clear(process->token_buffer);
+  return process->token_buffer;
 }
 
-static struct pos lex_file_position() { return lex_process->pos; }
+/**
+ * @brief 把临时缓冲中的token内容按实际长度拷入arena
+ *
+ * @param buffer
+ * @return const char*
+ */
+static const char *lexer_token_text(struct lex_process *process,
+                                    struct buffer *buffer) {
+  return arena_strndup(process->compiler->arena, buffer_ptr(buffer),
+                       buffer->len);
+}
 
-struct token *token_create(struct token *_token) {
-  memcpy(&tmp_token, _token, sizeof(struct token));
+struct token *token_create(struct lex_process *process,
+                           struct token *_token) {
+  struct token *token = &process->tmp_token;
+  memcpy(token, _token, sizeof(struct token));
   // 记录当前符号在文件中的位置
-  tmp_token.pos = lex_file_position();
-
-  if (lex_is_in_expression()) {
-    tmp_token.between_brackets = buffer_ptr(lex_process->parentheses_buffer);
+  token->offset = process->token_start;
+  if (process->newline_pending) {
+    token->flags |= TOKEN_FLAG_NEWLINE;
+    process->newline_pending = false;
   }
-  return &tmp_token;
+  return token;
 }
 
-static struct token *lexer_last_token() {
-  return vector_back_or_null(lex_process->token_vec);
+/*----------token storage: token_vec or streaming ring-----------*/
+static struct token *lexer_ring_at(struct lex_token_ring *ring, size_t index) {
+  return &ring->tokens[index & (ring->capacity - 1)];
 }
 
-static struct token *handle_whitespace() {
-  struct token *last_token = lexer_last_token();
-  if (last_token) {
-    last_token->whitespace = true;
+/**
+ * @brief 最早仍需保留的token序号：未交出的token及检查点之后的token
+ */
+static size_t lexer_ring_head(struct lex_token_ring *ring) {
+  if (vector_empty(ring->saves)) {
+    return ring->next;
   }
-
-  nextc();
-  return read_next_token();
+  return *(size_t *)vector_at(ring->saves, 0);
 }
 
-const char *read_number_str() {
-  const char *num = NULL;
-  struct buffer *buffer = buffer_create();
-  char c = peekc();
-  LEX_GETC_IF(buffer, c, (c >= '0' && c <= '9'));
-
-  // 写入字符串结束符 \0
-  buffer_write(buffer, 0x00);
-  return buffer_ptr(buffer);
+static void lexer_ring_grow(struct lex_token_ring *ring) {
+  size_t capacity = ring->capacity * 2;
+  struct token *tokens = malloc(capacity * sizeof(struct token));
+  for (size_t i = lexer_ring_head(ring); i < ring->tail; i++) {
+    tokens[i & (capacity - 1)] = *lexer_ring_at(ring, i);
+  }
+  free(ring->tokens);
+  ring->tokens = tokens;
+  ring->capacity = capacity;
 }
 
-unsigned long long read_number() {
-  const char *s = read_number_str();
-  return atoll(s);
+/**
+ * @brief 已生成的token数，也是下一个token的下标
+ */
+static size_t lexer_token_count(struct lex_process *process) {
+  if (process->ring) {
+    return process->ring->tail;
+  }
+  return vector_count(process->token_vec);
 }
 
-int lexer_number_type(char c) {
-  int res = NUMBER_TYPE_NORMAL;
-  if ('L' == c || 'l' == c) {
-    res = NUMBER_TYPE_LONG;
-  } else if ('f' == c || 'F' == c) {
-    res = NUMBER_TYPE_FLOAT;
-  } else if ('d' == c || 'D' == c) {
-    res = NUMBER_TYPE_DOUBLE;
+static void lexer_push_token(struct lex_process *process, struct token *token) {
+  struct lex_token_ring *ring = process->ring;
+  if (!ring) {
+    vector_push(process->token_vec, token);
+    return;
   }
 
-  return res;
+  if (ring->tail - lexer_ring_head(ring) == ring->capacity) {
+    lexer_ring_grow(ring);
+  }
+  *lexer_ring_at(ring, ring->tail++) = *token;
 }
 
-struct token *token_make_number_for_value(unsigned long number) {
-  int number_type = lexer_number_type(peekc());
-  if (NUMBER_TYPE_NORMAL != number_type) {
-    // skip l, f, d...
-    nextc();
+static struct token *lexer_last_token(struct lex_process *process) {
+  struct lex_token_ring *ring = process->ring;
+  if (!ring) {
+    return vector_back_or_null(process->token_vec);
   }
-  return token_create(&(struct token){
-      .type = TOKEN_TYPE_NUMBER, .llnum = number, .num.type = number_type});
+
+  if (ring->tail == 0) {
+    return NULL;
+  }
+  return lexer_ring_at(ring, ring->tail - 1);
 }
 
-struct token *token_make_number() {
-  return token_make_number_for_value(read_number());
+/*----------func used for elide comments and newlines-----------*/
+static bool lexer_elide_trivia(struct lex_process *process) {
+  return process->compiler->flags & COMPILE_PROCESS_FLAG_ELIDE_TRIVIA;
 }
 
-struct token *token_make_string(char start_delim, char end_delimi) {
-  struct buffer *buf = buffer_create();
-  // 处理左引号 "
-  assert(nextc() == start_delim);
-  char c = nextc();
-  for (; c != end_delimi && c != EOF; c = nextc()) {
-    // 处理转义字符
-    if ('\\' == c) {
-      continue;
-    }
+/**
+ * @brief 省略注释时不生成token，注释与空白一样分隔前后的token
+ */
+static struct token *lexer_elide_comment(struct lex_process *process) {
+  struct token *last_token = lexer_last_token(process);
+  if (last_token) {
+    last_token->flags |= TOKEN_FLAG_WHITESPACE;
   }
-
-  // 添加字符串结束标志0
-  buffer_write(buf, 0x00);
-  return token_create(
-      &(struct token){.flag = TOKEN_TYPE_STRING, .sval = buffer_ptr(buf)});
+  return NULL;
 }
 
-/*----------func used for make string token-----------*/
 /**
- * @brief 判断运算符是否有效（是否是C支持的）
+ * @brief offset处的换行紧跟在'\\'之后，是续行而不是指令的结尾
  *
- * @param op
- * @return true
- * @return false
- */
-bool op_valid(const char *op) {
-  // 注意指针* 与乘法运算 *
-  return S_EQ(op, "(") ||   // 点
-         S_EQ(op, "[") ||   // 点
-         S_EQ(op, "->") ||  // 指向结构体成员运算符
-         S_EQ(op, ".") ||   // 结构体成员运算符
-         S_EQ(op, "!") ||   // 单目运算符
-         S_EQ(op, "~") || S_EQ(op, "++") || S_EQ(op, "--") || S_EQ(op, "-") ||
-         S_EQ(op, "*") || S_EQ(op, "&") || S_EQ(op, "*") ||  // 双目运算符
-         S_EQ(op, "/") || S_EQ(op, "%") || S_EQ(op, "+") || S_EQ(op, "-") ||
-         S_EQ(op, "<<") ||                   // 移位运算
-         S_EQ(op, ">>") || S_EQ(op, "<") ||  // 关系运算
-         S_EQ(op, ">") || S_EQ(op, "<=") || S_EQ(op, ">=") || S_EQ(op, "==") ||
-         S_EQ(op, "!=") || S_EQ(op, "+") ||  // 位运算
-         S_EQ(op, "&") || S_EQ(op, "^") || S_EQ(op, "|") ||
-         S_EQ(op, "&&") ||                   // 逻辑运算
-         S_EQ(op, "||") || S_EQ(op, "?") ||  // 三目？
-         S_EQ(op, "=") ||                    // 赋值运算符
-         S_EQ(op, "+=") || S_EQ(op, "-=") || S_EQ(op, "*=") || S_EQ(op, "/=") ||
-         S_EQ(op, "%=") || S_EQ(op, ">>=") || S_EQ(op, "<<=") ||
-         S_EQ(op, "&=") || S_EQ(op, "^=") || S_EQ(op, "|=") ||
-         S_EQ(op, ",") ||  // 逗号
-         S_EQ(op, "...");  // 可变参数？？
-}
-
-static bool op_treated_as_one(char op) {
-  return op == '(' || op == '[' || op == ',' || op == '.' || op == '*' ||
-         op == '?';
-}
-
-static bool is_single_operator(char op) {
-  return op == '+' || op == '-' || op == '*' || op == '/' || op == '=' ||
-         op == '&' || op == '|' || op == '!' || op == '~' || op == '^' ||
-         op == '>' || op == '<' || op == '%' || op == '(' || op == '[' ||
-         op == ',' || op == '.' || op == '?';
-}
-
-/**
- * @brief 处理读入不正确操作符，例如+* -* *- /+
- * 将读入到buffer的内容，除第一个外，回退到文件流
- * @param buffer
+ * @param last 换行前的token
  */
-void read_op_flush_back_keep_first(struct buffer *buffer) {
-  const char *data = buffer_ptr(buffer);
-  int len = buffer->len;
-  for (int i = len - 1; i >= 1; --i) {
-    if (0x00 == data[i]) {
-      continue;
-    }
-    pushc(data[i]);
-  }
+static bool lexer_continues_line(struct token *last, size_t offset) {
+  return last && TOKEN_TYPE_SYMBOL == last->type && '\\' == last->cval &&
+         last->offset + 1 == offset;
 }
 
-const char *read_op() {
-  bool single_operator = true;
-  char op = nextc();
-  struct buffer *buffer = buffer_create();
-  buffer_write(buffer, op);
+/*----------func used for make number token-----------*/
+/**
+ * @brief 读数字用的游标：连续内存按下标读取，读完一次跳过；
+ * 流式输入逐字符读取，读过的字符留在token_buffer中供慢速路径使用
+ */
+struct lex_number_cursor {
+  struct lex_process *process;
+  const char *p;
+  size_t len;
+  size_t pos;
+};
+
+// 单趟扫描数字的结果
+struct lex_number {
+  // 整数值
+  unsigned long long value;
+  // 浮点数的有效数字，指数十进制为10的幂，十六进制为2的幂
+  unsigned long long mantissa;
+  int exponent;
+  // 有效数字超出mantissa，浮点数只能走慢速路径
+  bool inexact;
+  bool overflow;
+  // 出现了超出进制的数字，如0b12、089
+  bool invalid;
+};
+
+// 10的0到22次幂都能用double精确表示
+static const double lex_pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                   1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                   1e18, 1e19, 1e20, 1e21, 1e22};
+
+// 不超过2^53的有效数字可以精确转为double
+#define LEX_EXACT_MANTISSA (1ULL << 53)
 
-  if (!op_treated_as_one(op)) {
-    op = peekc();
-    if (is_single_operator(op)) {
-      buffer_write(buffer, op);
-      nextc();
-      single_operator = false;
-    }
+/**
+ * @brief 数字的源码文本，只在慢速路径上取用
+ */
+static const char *lex_number_text(struct lex_number_cursor *cursor) {
+  struct buffer *buffer = cursor->process->token_buffer;
+  if (cursor->p) {
+    buffer_write_bytes(buffer, cursor->p, cursor->pos);
   }
-
   buffer_write(buffer, 0x00);
-  char *ptr = buffer_ptr(buffer);
-
-  // 至此已读入一个完整的operator，可能是单个字符如 +，可能是多个如 >>=
-  // 需要判断读入的operator是否是有效的，或者说是否是C supported
-  if (!single_operator) {
-    if (!op_valid(
-            ptr)) {  // 判断是否是一个有效的操作符，无效则只保留一个符号，其余写回
-      read_op_flush_back_keep_first(buffer);
-      // 保留第一个，写入字符串terminator
-      ptr[1] = 0x00;
-    }
-  } else if (!op_valid(ptr)) {
-    compiler_error(lex_process->compiler, "The operator %s is not valid\n",
-                   ptr);
-  }
-
-  return ptr;
+  return buffer_ptr(buffer);
 }
 
-static void lex_new_expression() {
-  lex_process->current_expression_count++;
-  if (1 == lex_process->current_expression_count) {
-    lex_process->parentheses_buffer = buffer_create();
+static int lex_digit_value(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
   }
-}
-
-static void lex_finish_expression() {
-  lex_process->current_expression_count--;
-  if (lex_process->current_expression_count < 0) {
-    compiler_error(lex_process->compiler,
-                   "You closed an expression that you never opened.\n");
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
   }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return 16;
 }
 
-bool lex_is_in_expression() {
-  return lex_process->current_expression_count > 0;
-}
-
-bool is_keyword(const char *str) {
-  return S_EQ(str, "void") ||  // 基本数据类型关键字  5
-         S_EQ(str, "char") || S_EQ(str, "int") || S_EQ(str, "float") ||
-         S_EQ(str, "double") || S_EQ(str, "short") ||  // 类型修饰关键字  4
-         S_EQ(str, "long") || S_EQ(str, "signed") || S_EQ(str, "unsigned") ||
-         S_EQ(str, "struct") ||  // 复杂类型关键字  5
-         S_EQ(str, "union") || S_EQ(str, "enum") || S_EQ(str, "typedef") ||
-         S_EQ(str, "sizeof") || S_EQ(str, "auto") ||  // 存储级别关键字  6
-         S_EQ(str, "static") || S_EQ(str, "register") || S_EQ(str, "extern") ||
-         S_EQ(str, "const") || S_EQ(str, "volatile") ||
-         S_EQ(str, "return") ||  // 跳转结构  4
-         S_EQ(str, "continue") || S_EQ(str, "break") || S_EQ(str, "goto") ||
-         S_EQ(str, "if") ||  // 分支结构  5
-         S_EQ(str, "else") || S_EQ(str, "switch") || S_EQ(str, "case") ||
-         S_EQ(str, "default") || S_EQ(str, "for") ||  // 循环结构  3
-         S_EQ(str, "do") || S_EQ(str, "while") ||
-         S_EQ(str, "__ignore_typecheck") || S_EQ(str, "include") ||
-         S_EQ(str, "restrict");
+static double lex_pow2(int exponent) {
+  union {
+    unsigned long long bits;
+    double value;
+  } pow2 = {.bits = (unsigned long long)(exponent + 1023) << 52};
+  return pow2.value;
 }
 
-static struct token *token_make_operator_or_string() {
-  char op = peekc();
-  if ('<' == op) {  // 处理类似 #include<abc.h>
-    struct token *last_token = lexer_last_token();
-    if (token_is_keyword(last_token, "include")) {
-      return token_make_string('<', '>');
+/**
+ * @brief 有效数字可以精确表示且指数不大时直接换算，
+ * 结果只舍入一次，与strtod一致；否则交给strtod
+ *
+ * @param single 带f后缀，慢速路径用strtof避免两次舍入
+ */
+static double lex_number_double(struct lex_number_cursor *cursor,
+                                struct lex_number *number, bool hex,
+                                bool single) {
+  if (!number->inexact && number->mantissa <= LEX_EXACT_MANTISSA) {
+    double mantissa = (double)number->mantissa;
+    int exponent = number->exponent;
+    if (hex && exponent >= -1022 && exponent <= 1023) {
+      return mantissa * lex_pow2(exponent);
+    }
+    if (!hex && exponent >= -22 && exponent <= 22) {
+      return exponent < 0 ? mantissa / lex_pow10[-exponent]
+                          : mantissa * lex_pow10[exponent];
     }
   }
 
-  struct token *token = token_create(
-      &(struct token){.type = TOKEN_TYPE_OPERATOR, .sval = read_op()});
-  if ('(' == op) {  // 处理类似 (exp)
-    lex_new_expression();
-  }
-
-  return token;
-}
-
-/*----------func used for make symbol token-----------*/
-static struct token *token_make_symbol() {
-  char c = nextc();
-  if (')' == c) {
-    lex_finish_expression();
-  }
-
-  struct token *token =
-      token_create(&(struct token){.type = TOKEN_TYPE_SYMBOL, .cval = c});
-  return token;
+  const char *text = lex_number_text(cursor);
+  return single ? strtof(text, NULL) : strtod(text, NULL);
 }
 
-/*----------func used for make identifier token-----------*/
-struct token *token_make_identifier_or_keyword() {
-  struct buffer *buffer = buffer_create();
-  char c = 0;
-  LEX_GETC_IF(buffer, c,
-              (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
-                  (c >= '0') && (c <= '9') || (c == '_'));
-
-  buffer_write(buffer, 0x00);
-
-  // 检查是否是关键字
-  if (is_keyword(buffer_ptr(buffer))) {
-    return token_create(&(struct token){.type = TOKEN_TYPE_KEYWORD,
-                                        .sval = buffer_ptr(buffer)});
+/**
+ * @brief 进入括号，最外层的'('记录括号内的起始位置，此时'('尚未写入token_vec
+ */
+static void lex_new_expression(struct lex_process *process) {
+  process->current_expression_count++;
+  if (1 == process->current_expression_count) {
+    process->open_brackets.first = lexer_token_count(process) + 1;
+    process->open_brackets.start = process->offset;
   }
-  return token_create(&(struct token){.type = TOKEN_TYPE_IDENTIFIER,
-                                      .sval = buffer_ptr(buffer)});
 }
 
-struct token *read_special_token() {
-  char c = peekc();
-  if (isalpha(c) || '_' == c) {
-    return token_make_identifier_or_keyword();
+/**
+ * @brief 最外层括号结束，括号内的token范围和源码区间写入旁表
+ *
+ * @param end 括号内源码的结束偏移
+ */
+static void lex_close_brackets(struct lex_process *process, size_t end) {
+  // 流式分析不保留旁表，内存占用与输入长度无关
+  if (process->ring) {
+    return;
   }
-  return NULL;
-}
 
-/*----------func used for make comment token-----------*/
-struct token *token_make_one_line_comment() {
-  struct buffer *buffer = buffer_create();
-  char c = 0;
-  LEX_GETC_IF(buffer, c, (c != '\n' && c != EOF));
-  return token_create(
-      &(struct token){.type = TOKEN_TYPE_COMMENT, .sval = buffer_ptr(buffer)});
-}
-
-struct token *token_make_multi_line_comment() {
-  struct buffer *buffer = buffer_create();
-  char c = 0;
-  while (1) {
-    LEX_GETC_IF(buffer, c, c != '*' && c != EOF);
-    if (EOF == c) {
-      compiler_error(lex_process->compiler,
-                     "You did not close this multiline comment.\n");
-    } else if ('*' == c) {
-      // 继续读一个
-      nextc();
-      if ('/' == peekc()) {
-        // skip '/'
-        nextc();
-        break;
-      }
-    }
+  process->open_brackets.last = lexer_token_count(process) - 1;
+  process->open_brackets.end = end;
+  // 空括号内没有token，无需记录
+  if (process->open_brackets.first <= process->open_brackets.last) {
+    vector_push(process->between_brackets_vec, &process->open_brackets);
   }
-  return token_create(
-      &(struct token){.type = TOKEN_TYPE_COMMENT, .sval = buffer_ptr(buffer)});
 }
 
-struct token *handle_comment() {
-  char c = peekc();
-  if ('/' == c) {
-    nextc();
-    if ('/' == peekc()) {
-      nextc();
-      return token_make_one_line_comment();
-    } else if ('*' == peekc()) {
-      nextc();
-      return token_make_multi_line_comment();
-    }
-
-    // '/'可作为注释开头，单个出现则是除法运算符，故放在这里处理
-    // 压回'/'，按除法运算符生成token
-    pushc('/');
-    return token_make_operator_or_string();
+static void lex_finish_expression(struct lex_process *process) {
+  process->current_expression_count--;
+  if (process->current_expression_count < 0) {
+    lexer_error(process, "You closed an expression that you never opened.\n");
   }
-  return NULL;
-}
-
-/*----------func used for make special number token-----------*/
-/*处理：0xAB45*/
-
-void lexer_pop_token() { vector_pop(lex_process->token_vec); }
-
-bool is_hex_char(char c) {
-  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
-         (c >= 'A' && c <= 'F');
-}
-
-const char *read_hex_number_str() {
-  struct buffer *buffer = buffer_create();
-  char c = peekc();
-  LEX_GETC_IF(buffer, c, is_hex_char(c));
-
-  // 写入字符串结束符
-  buffer_write(buffer, 0x00);
-  return buffer_ptr(buffer);
-}
-
-struct token *token_make_special_number_hexadecimal() {
-  // skip x
-  nextc();
 
-  unsigned long number = 0;
-  const char *number_str = read_hex_number_str();
-  number = strtol(number_str, 0, 16);
-
-  return token_make_number_for_value(number);
-}
-
-/*处理：0b123*/
-void lexer_validate_binary_string(const char *str) {
-  size_t len = strlen(str);
-  for (int i = 0; i < len; i++) {
-    if ('0' != str[i] && '1' != str[i]) {
-      compiler_error(lex_process->compiler,
-                     "This is not a valid binary number.\n");
-    }
+  if (0 == process->current_expression_count) {
+    // 此时')'已读入，尚未写入token_vec
+    lex_close_brackets(process, process->token_start);
   }
 }
 
-struct token *token_make_special_number_binary() {
-  // skip b
-  nextc();
-
-  unsigned long number = 0;
-  const char *number_str = read_number_str();
-  lexer_validate_binary_string(number_str);
-  number = strtol(number_str, 0, 2);
-
-  return token_make_number_for_value(number);
+bool lex_is_in_expression(struct lex_process *process) {
+  return process->current_expression_count > 0;
 }
 
-struct token *token_make_special_number() {
-  struct token *token = NULL;
-  struct token *last_token = lexer_last_token();
-
-  // pop 0xAB 中的0
-  lexer_pop_token();
-
-  char c = peekc();
-  if ('x' == c) {
-    token = token_make_special_number_hexadecimal();
-  } else if ('b' == c) {
-    token = token_make_special_number_binary();
+static struct token *token_make_operator(struct lex_process *process, int op) {
+  struct token *token = token_create(process, &(struct token){
+      .type = TOKEN_TYPE_OPERATOR, .op = op, .sval = operator_name(op)});
+  if (OPERATOR_LPAREN == op) {  // 处理类似 (exp)
+    lex_new_expression(process);
   }
 
   return token;
@@ -498,90 +361,204 @@ char lex_get_escaped_char(char c) {
   return co;
 }
 
-struct token *token_make_quote() {
-  // 读入并判断左单引号
-  assert_next_char('\'');
-  // 读入''中的内容  ASCII：0-255
-  char c = nextc();
-  if ('\\' == c) {
-    // 处理转义字符  '\\t'
-    c = nextc();
-    c = lex_get_escaped_char(c);
+/*----------dispatch of read_next_token-----------*/
+// 首字符的类别，决定read_next_token进入的状态
+enum {
+  LEX_CLASS_INVALID,
+  LEX_CLASS_END,
+  LEX_CLASS_BLANK,
+  LEX_CLASS_NEWLINE,
+  LEX_CLASS_DIGIT,
+  LEX_CLASS_IDENTIFIER,
+  LEX_CLASS_OPERATOR,
+  LEX_CLASS_SLASH,
+  LEX_CLASS_SYMBOL,
+  LEX_CLASS_STRING,
+  LEX_CLASS_QUOTE,
+  LEX_CLASS_COUNT
+};
+
+#define X LEX_CLASS_INVALID
+#define E LEX_CLASS_END
+#define B LEX_CLASS_BLANK
+#define N LEX_CLASS_NEWLINE
+#define D LEX_CLASS_DIGIT
+#define I LEX_CLASS_IDENTIFIER
+#define O LEX_CLASS_OPERATOR
+#define S LEX_CLASS_SLASH
+#define Y LEX_CLASS_SYMBOL
+#define Q LEX_CLASS_STRING
+#define C LEX_CLASS_QUOTE
+// 按字节取类别，EOF与0xFF同为LEX_CLASS_END
+static const uint8_t lex_char_class[256] = {
+    X, X, X, X, X, X, X, X, X, B, N, X, X, X, X, X, // 0x00
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, // 0x10
+    B, O, Q, Y, X, O, O, C, O, Y, O, O, O, O, O, S, // 0x20
+    D, D, D, D, D, D, D, D, D, D, Y, Y, O, O, O, O, // 0x30
+    X, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I, // 0x40
+    I, I, I, I, I, I, I, I, I, I, I, O, Y, Y, O, I, // 0x50
+    X, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I, // 0x60
+    I, I, I, I, I, I, I, I, I, I, I, Y, O, Y, O, X, // 0x70
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, // 0x80
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, // 0x90
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, // 0xA0
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, // 0xB0
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, // 0xC0
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, // 0xD0
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, // 0xE0
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, E, // 0xF0
+};
+#undef X
+#undef E
+#undef B
+#undef N
+#undef D
+#undef I
+#undef O
+#undef S
+#undef Y
+#undef Q
+#undef C
+
+// GCC、Clang可取标签地址，按类别直接跳到对应状态，其余编译器退回switch
+#if defined(__GNUC__)
+#define LEX_COMPUTED_GOTO
+#define LEX_DISPATCH(state) goto *lex_states[state];
+#define LEX_STATE(state) lex_state_##state
+#else
+#define LEX_DISPATCH(state) switch (state)
+#define LEX_STATE(state) case state
+#endif
+
+/*----------lexer core, one instance per input backend-----------*/
+#define LEX_CORE_FN(name) LEX_CORE_FN_(name, LEX_CORE_NAME)
+#define LEX_CORE_FN_(name, suffix) LEX_CORE_FN__(name, suffix)
+#define LEX_CORE_FN__(name, suffix) name##_##suffix
+
+// 调用者自定义的函数表只能逐字符间接调用，作为通用的慢速实现
+#define LEX_CORE_NAME generic
+#define LEX_CORE_NEXT_CHAR(process) (process)->functions->next_char(process)
+#define LEX_CORE_PEEK_CHAR(process) (process)->functions->peek_char(process)
+#define LEX_CORE_PUSH_CHAR(process, c) \
+  (process)->functions->push_char(process, c)
+#define LEX_CORE_REMAINING(process, len)                       \
+  ((process)->functions->remaining                             \
+       ? (process)->functions->remaining(process, len) \
+       : NULL)
+#define LEX_CORE_SKIP(process, len) (process)->functions->skip(process, len)
+#include "lexer_core.h"
+
+// stdio读取的文件，如管道，只能逐字符读取
+#define LEX_CORE_NAME stream
+#define LEX_CORE_NEXT_CHAR(process) lex_input_stream_next((process)->compiler)
+#define LEX_CORE_PEEK_CHAR(process) lex_input_stream_peek((process)->compiler)
+#define LEX_CORE_PUSH_CHAR(process, c) \
+  lex_input_stream_push((process)->compiler, c)
+#define LEX_CORE_REMAINING(process, len) \
+  ((void)(process), (void)(len), (const char *)NULL)
+#define LEX_CORE_SKIP(process, len) assert(!"stream input cannot skip")
+#include "lexer_core.h"
+
+// 映射到内存的文件
+#define LEX_CORE_NAME mapped
+#define LEX_CORE_CFILE(process) (process)->compiler->cfile
+#define LEX_CORE_NEXT_CHAR(process)                                      \
+  lex_input_buffer_next(LEX_CORE_CFILE(process).data,                   \
+                        LEX_CORE_CFILE(process).size,                   \
+                        &LEX_CORE_CFILE(process).offset)
+#define LEX_CORE_PEEK_CHAR(process)                                      \
+  lex_input_buffer_peek(LEX_CORE_CFILE(process).data,                   \
+                        LEX_CORE_CFILE(process).size,                   \
+                        LEX_CORE_CFILE(process).offset)
+#define LEX_CORE_PUSH_CHAR(process, c)                                   \
+  lex_input_buffer_push(LEX_CORE_CFILE(process).data,                   \
+                        &LEX_CORE_CFILE(process).offset, c)
+#define LEX_CORE_REMAINING(process, len)                                 \
+  lex_input_buffer_remaining(LEX_CORE_CFILE(process).data,              \
+                             LEX_CORE_CFILE(process).size,              \
+                             LEX_CORE_CFILE(process).offset, len)
+#define LEX_CORE_SKIP(process, len)                                      \
+  lex_input_buffer_skip(LEX_CORE_CFILE(process).size,                   \
+                        &LEX_CORE_CFILE(process).offset, len)
+#include "lexer_core.h"
+#undef LEX_CORE_CFILE
+
+// 调用者提供的内存，字串、生成的代码、增量分析及并行分析的块
+#define LEX_CORE_NAME memory
+#define LEX_CORE_NEXT_CHAR(process)                                \
+  lex_input_buffer_next((process)->memory.data, (process)->memory.size, \
+                        &(process)->memory.offset)
+#define LEX_CORE_PEEK_CHAR(process)                                \
+  lex_input_buffer_peek((process)->memory.data, (process)->memory.size, \
+                        (process)->memory.offset)
+#define LEX_CORE_PUSH_CHAR(process, c) \
+  lex_input_buffer_push((process)->memory.data, &(process)->memory.offset, c)
+#define LEX_CORE_REMAINING(process, len)                                 \
+  lex_input_buffer_remaining((process)->memory.data, (process)->memory.size, \
+                             (process)->memory.offset, len)
+#define LEX_CORE_SKIP(process, len) \
+  lex_input_buffer_skip((process)->memory.size, &(process)->memory.offset, len)
+#include "lexer_core.h"
+
+// 已展开实例的输入方式，其余函数表走通用实现
+enum {
+  LEX_INPUT_GENERIC,
+  LEX_INPUT_STREAM,
+  LEX_INPUT_MAPPED,
+  LEX_INPUT_MEMORY
+};
+
+static int lexer_input(struct lex_process *process) {
+  if (&compiler_mmap_lex_functions == process->functions) {
+    return LEX_INPUT_MAPPED;
   }
-
-  // 判断右单引号
-  if ('\'' != nextc()) {
-    compiler_error(
-        lex_process->compiler,
-        "You open a quote ' but did not close it with a ' character.\n");
+  // 只有private指向process->memory时源码位置才在process中
+  if (&lexer_memory_functions == process->functions &&
+      &process->memory == process->private) {
+    return LEX_INPUT_MEMORY;
   }
-
-  return token_create(&(struct token){.type = TOKEN_TYPE_NUMBER, .cval = c});
-}
-
-/*----------func used for make newline token-----------*/
-static struct token *token_make_newline() {
-  nextc();
-  return token_create(&(struct token){.type = TOKEN_TYPE_NEWLINE});
+  if (&compiler_lex_functions == process->functions) {
+    return LEX_INPUT_STREAM;
+  }
+  return LEX_INPUT_GENERIC;
 }
 
-struct token *read_next_token() {
-  struct token *token = NULL;
-  char c = peekc();
-
-  token = handle_comment();
-  if (token) {
-    return token;
+/**
+ * @brief 读下一个token，每次调用按输入方式选择实例
+ *
+ * @return struct token* 读到输入结尾返回NULL
+ */
+struct token *read_next_token(struct lex_process *process) {
+  switch (lexer_input(process)) {
+    case LEX_INPUT_MAPPED:
+      return read_next_token_mapped(process);
+    case LEX_INPUT_MEMORY:
+      return read_next_token_memory(process);
+    case LEX_INPUT_STREAM:
+      return read_next_token_stream(process);
+    default:
+      return read_next_token_generic(process);
   }
+}
 
-  switch (c) {
-  NUMERIC_CASE:
-    token = token_make_number();
-    break;
-
-  OPERATOR_CASE_EXCLUDING_DIVISION:
-    token = token_make_operator_or_string();
-    break;
-
-  SYMBOL_CASE:
-    token = token_make_symbol();
-    break;
-
-    case 'x':
-    case 'b':
-      token = token_make_special_number();
-      break;
-
-    case '"':
-      token = token_make_string('"', '"');
-      break;
-
-    case '\'':
-      token = token_make_quote();
-      break;
-
-    case ' ':
-    case '\t':
-      token = handle_whitespace();
+/**
+ * @brief 读完剩余输入，只在开始时选择一次实例
+ */
+static void lexer_read_tokens(struct lex_process *process) {
+  switch (lexer_input(process)) {
+    case LEX_INPUT_MAPPED:
+      lex_tokens_mapped(process);
       break;
-
-    case '\n':
-      token = token_make_newline();
+    case LEX_INPUT_MEMORY:
+      lex_tokens_memory(process);
       break;
-
-    case EOF:
-      /* 读到文件尾表示顺利完成分析 */
+    case LEX_INPUT_STREAM:
+      lex_tokens_stream(process);
       break;
-
     default:
-      token = read_special_token();
-      if (!token) {
-        // 读到不能识别的字符
-        compiler_error(lex_process->compiler, "Unexpected token\n");
-      }
+      lex_tokens_generic(process);
+      break;
   }
-
-  return token;
 }
 
 /**
@@ -592,63 +569,163 @@ struct token *read_next_token() {
  */
 int lex(struct lex_process *process) {
   process->current_expression_count = 0;
-  process->parentheses_buffer = NULL;
-  lex_process = process;
   process->pos.filename = process->compiler->cfile.abs_path;
 
-  struct token *token = read_next_token();
-
   // 处理文件，获得token
-  while (token) {
-    vector_push(process->token_vec, token);
-    token = read_next_token();
+  lexer_read_tokens(process);
+
+  // 未闭合的括号一直延续到输入结尾
+  if (lex_is_in_expression(process)) {
+    lex_close_brackets(process, process->offset);
   }
-  gdb_print_lexer_token_vec(lex_process);
   return LEXICAL_ANALYSISI_ALL_OK;
 }
 
+// 起点处的括号深度未知时从这个基准开始计数，')'不会被误判为多余，也不记录旁表
+#define LEX_EXPRESSION_BASE (1 << 20)
+
+/**
+ * @brief 从当前偏移分析到输入结尾，起点可以位于括号内，括号由调用者统一计算
+ *
+ * @param process
+ * @param context 起点前的token，决定空白标记、#include<...>等上下文，
+ * 分析后留在token_vec开头
+ * @return int
+ */
+int lex_chunk(struct lex_process *process, struct token *context) {
+  process->current_expression_count = LEX_EXPRESSION_BASE;
+  process->pos.filename = process->compiler->cfile.abs_path;
+  if (context) {
+    lexer_push_token(process, context);
+    // 起点在换行之后，第一个token位于行首
+    process->newline_pending =
+        lexer_elide_trivia(process) && TOKEN_TYPE_NEWLINE == context->type;
+  }
+
+  lexer_read_tokens(process);
+  return LEXICAL_ANALYSISI_ALL_OK;
+}
+
+/**
+ * @brief 确保下一个token可以交给调用者
+ * token只有在其后的token也读入后才算完成：空白会给前一个token加标记，
+ * 所以始终多读一个token
+ *
+ * @return struct lex_token_ring*
+ */
+static struct lex_token_ring *lex_stream_fill(struct lex_process *process) {
+  struct lex_token_ring *ring = process->ring;
+  if (!ring) {
+    ring = calloc(1, sizeof(struct lex_token_ring));
+    ring->capacity = LEX_TOKEN_RING_INITIAL_CAPACITY;
+    ring->tokens = malloc(ring->capacity * sizeof(struct token));
+    ring->saves = vector_create(sizeof(size_t));
+    process->ring = ring;
+    process->current_expression_count = 0;
+    process->pos.filename = process->compiler->cfile.abs_path;
+  }
+
+  while (!ring->done && ring->tail <= ring->next + 1) {
+    struct token *token = read_next_token(process);
+    if (!token) {
+      ring->done = true;
+      break;
+    }
+    lexer_push_token(process, token);
+  }
+  return ring;
+}
+
+struct token *lex_peek_token(struct lex_process *process) {
+  struct lex_token_ring *ring = lex_stream_fill(process);
+  if (ring->next == ring->tail) {
+    return NULL;
+  }
+  return lexer_ring_at(ring, ring->next);
+}
+
+/**
+ * @brief 流式读取下一个token，只保留尚未交出及检查点之后的token
+ *
+ * @param process
+ * @return struct token* 下次调用前有效，读完返回NULL
+ */
+struct token *lex_next_token(struct lex_process *process) {
+  struct token *token = lex_peek_token(process);
+  if (token) {
+    process->ring->next++;
+  }
+  return token;
+}
+
+void lex_save(struct lex_process *process) {
+  struct lex_token_ring *ring = lex_stream_fill(process);
+  vector_push(ring->saves, &ring->next);
+}
+
+void lex_restore(struct lex_process *process) {
+  struct lex_token_ring *ring = process->ring;
+  ring->next = *(size_t *)vector_back(ring->saves);
+  vector_pop(ring->saves);
+}
+
+void lex_save_purge(struct lex_process *process) {
+  vector_pop(process->ring->saves);
+}
+
+/*----------func used for lexing memory-----------*/
 /**
- * @brief 较char compile_process_peek_char(struct lex_process* lex_process)
- * 以下几个函数是从buffer中读取，算是sub_lexer，应该是用于处理lex_process.parentheses_buffer中的内容
- * lex_process.parentheses_buffer会在输入中包含（）时创建
- * 而compile_process_peek_char及相应的几个函数
- * 处理的是输入文件流，算是sub_compiler，前者buffer数据来源于文件流
+ * @brief 以下几个函数直接读取调用者提供的内存，用于分析字串、生成的代码及增量分析
+ * 与compile_process_mmap_next_char等相同，数据连续，支持批量扫描
  * @param process
  * @return char
  */
-char lexer_string_buffer_next_char(struct lex_process *process) {
-  struct buffer *buf = lex_process_private(process);
-  return buffer_read(buf);
+static char lexer_memory_next_char(struct lex_process *process) {
+  struct lex_memory_source *source = lex_process_private(process);
+  return lex_input_buffer_next(source->data, source->size, &source->offset);
+}
+
+static char lexer_memory_peek_char(struct lex_process *process) {
+  struct lex_memory_source *source = lex_process_private(process);
+  return lex_input_buffer_peek(source->data, source->size, source->offset);
+}
+
+static void lexer_memory_push_char(struct lex_process *process, char c) {
+  struct lex_memory_source *source = lex_process_private(process);
+  lex_input_buffer_push(source->data, &source->offset, c);
 }
 
-char lexer_string_buffer_peek_char(struct lex_process *process) {
-  struct buffer *buf = lex_process_private(process);
-  return buffer_peek(buf);
+static const char *lexer_memory_remaining(struct lex_process *process,
+                                          size_t *len) {
+  struct lex_memory_source *source = lex_process_private(process);
+  return lex_input_buffer_remaining(source->data, source->size,
+                                    source->offset, len);
 }
 
-void lexer_string_buffer_push_char(struct lex_process *process, char c) {
-  struct buffer *buf = lex_process_private(process);
-  buffer_write(buf, c);
+static void lexer_memory_skip(struct lex_process *process, size_t len) {
+  struct lex_memory_source *source = lex_process_private(process);
+  lex_input_buffer_skip(source->size, &source->offset, len);
 }
 
-struct lex_process_functions lexer_string_buffer_functions = {
-    .next_char = lexer_string_buffer_next_char,
-    .peek_char = lexer_string_buffer_peek_char,
-    .push_char = lexer_string_buffer_push_char};
+struct lex_process_functions lexer_memory_functions = {
+    .next_char = lexer_memory_next_char,
+    .peek_char = lexer_memory_peek_char,
+    .push_char = lexer_memory_push_char,
+    .remaining = lexer_memory_remaining,
+    .skip = lexer_memory_skip};
 
 /**
- * @brief 递归分析exp中括号内的内容
+ * @brief 分析内存中的源码，不拷贝data
  *
  * @param compiler
- * @param str
+ * @param data 只在分析期间读取，返回后可以释放
+ * @param size
  * @return struct lex_process*
  */
-struct lex_process *tokens_build_for_string(struct compile_process *compiler,
-                                            const char *str) {
-  struct buffer *buffer = buffer_create();
-  buffer_printf(buffer, str);
+struct lex_process *tokens_build_for_memory(struct compile_process *compiler,
+                                            const char *data, size_t size) {
   struct lex_process *lex_process =
-      lex_process_create(compiler, &lexer_string_buffer_functions, buffer);
+      lex_process_create_for_memory(compiler, data, size);
   if (!lex_process) {
     return NULL;
   }
@@ -657,5 +734,401 @@ struct lex_process *tokens_build_for_string(struct compile_process *compiler,
     return NULL;
   }
 
+  // token偏移相对于data，行列号使用data自己的行首索引
+  lex_process->lines = calloc(1, sizeof(struct line_index));
+  line_index_init(lex_process->lines);
+  line_index_build(lex_process->lines, data, size);
+
   return lex_process;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 递归分析exp中括号内的内容
+ *
+ * @param compiler
+ * @param str
+ * @return struct lex_process*
+ */
+struct lex_process *tokens_build_for_string(struct compile_process *compiler,
+                                            const char *str) {
+  return tokens_build_for_memory(compiler, str, strlen(str));
+}
+
+/*----------incremental relex-----------*/
+static struct token *lexer_token_at(struct vector *token_vec, int index) {
+  return vector_at(token_vec, index);
+}
+
+/**
+ * @brief 第一个偏移不小于offset的token
+ */
+static int lexer_first_token_at(struct lex_process *process, size_t offset) {
+  int low = 0;
+  int high = vector_count(process->token_vec);
+  while (low < high) {
+    int mid = (low + high) / 2;
+    if (lex_process_token_offset(process, mid) < offset) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/**
+ * @brief '('为1，')'为-1，其余为0
+ */
+int lex_token_paren_delta(struct token *token) {
+  if (TOKEN_TYPE_OPERATOR == token->type && OPERATOR_LPAREN == token->op) {
+    return 1;
+  }
+  if (TOKEN_TYPE_SYMBOL == token->type && ')' == token->cval) {
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief 下标index的运算符与前一个运算符之间没有空白
+ */
+static bool lexer_operator_adjacent(struct vector *token_vec, int index) {
+  struct token *prev = lexer_token_at(token_vec, index - 1);
+  struct token *token = lexer_token_at(token_vec, index);
+  return TOKEN_TYPE_OPERATOR == prev->type &&
+         TOKEN_TYPE_OPERATOR == token->type &&
+         !(prev->flags & TOKEN_FLAG_WHITESPACE);
+}
+
+/**
+ * @brief 下标index的换行token是续行
+ */
+static bool lexer_line_continued(struct lex_process *process, int index) {
+  if (index <= 0) {
+    return false;
+  }
+  struct token last = *lexer_token_at(process->token_vec, index - 1);
+  last.offset = lex_process_token_offset(process, index - 1);
+  return lexer_continues_line(&last, lex_process_token_offset(process, index));
+}
+
+/**
+ * @brief 省略换行时，读完下标index的token后是否位于预处理指令内
+ * 指令内的换行才会输出，从index往前找到所在逻辑行的第一个token
+ */
+static bool lexer_in_directive(struct lex_process *process, int index) {
+  struct vector *token_vec = process->token_vec;
+  for (int i = index; i >= 0; i--) {
+    struct token *token = lexer_token_at(token_vec, i);
+    if (TOKEN_TYPE_NEWLINE == token->type) {
+      if (!lexer_line_continued(process, i)) {
+        return false;
+      }
+      continue;
+    }
+
+    // 续行之后的行首不是逻辑行的开头
+    bool line_start = 0 == i || (token->flags & TOKEN_FLAG_NEWLINE);
+    if (line_start && !(i > 0 &&
+                        TOKEN_TYPE_NEWLINE ==
+                            lexer_token_at(token_vec, i - 1)->type &&
+                        lexer_line_continued(process, i - 1))) {
+      return TOKEN_TYPE_SYMBOL == token->type && '#' == token->cval;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief 比较token内容，不比较偏移和空白标记
+ */
+static bool lexer_token_equal(struct token *a, struct token *b) {
+  if (a->type != b->type || a->keyword != b->keyword) {
+    return false;
+  }
+
+  switch (a->type) {
+    case TOKEN_TYPE_STRING:
+    case TOKEN_TYPE_COMMENT:
+      return S_EQ(a->sval, b->sval);
+
+    case TOKEN_TYPE_NEWLINE:
+      return true;
+
+    default:
+      // 标识符已驻留，关键字、运算符指向静态字串，直接比较值即可
+      return a->llnum == b->llnum;
+  }
+}
+
+/**
+ * @brief 省略换行时，新token的行首标记和读完后的预处理指令状态与旧token相同
+ */
+static bool lexer_relex_trivia_equal(struct lex_process *relex,
+                                     struct token *token,
+                                     struct lex_process *process, int old) {
+  struct token *old_token = lexer_token_at(process->token_vec, old);
+  return (token->flags & TOKEN_FLAG_NEWLINE) ==
+             (old_token->flags & TOKEN_FLAG_NEWLINE) &&
+         relex->in_directive == lexer_in_directive(process, old);
+}
+
+/**
+ * @brief 拼接前调整token的延后平移，使拼接后的平移统一从新token之后开始
+ * 旧平移之前的保留token本来是准确值，旧平移之内的保留token少算了旧平移，
+ * 两者之间的token逐个改写，代价与上次编辑处到这次编辑处的距离成正比
+ *
+ * @param from 被替换的第一个token
+ * @param sync 第一个保留的旧token
+ */
+static void lexer_relex_rebase_tokens(struct lex_process *process, int from,
+                                      int sync) {
+  struct lex_pending_shift *shift = &process->shift;
+  if (0 == shift->offset) {
+    return;
+  }
+
+  uint32_t pending = (uint32_t)shift->offset;
+  // 编辑处之前仍带着旧平移的token改为准确值
+  for (int i = shift->token_from; i < from; i++) {
+    lexer_token_at(process->token_vec, i)->offset += pending;
+  }
+  // 编辑处之后本来准确的token改为减去旧平移存放
+  for (int i = sync; i < shift->token_from; i++) {
+    lexer_token_at(process->token_vec, i)->offset -= pending;
+  }
+}
+
+/**
+ * @brief 与lexer_relex_rebase_tokens相同，作用于括号旁表
+ *
+ * @param g0 被替换的第一个旁表元素
+ * @param g1 第一个保留的旧旁表元素
+ */
+static void lexer_relex_rebase_brackets(struct lex_process *process, int g0,
+                                        int g1) {
+  struct lex_pending_shift *shift = &process->shift;
+  if (0 == shift->count && 0 == shift->bracket_offset) {
+    return;
+  }
+
+  for (int i = shift->bracket_from; i < g0; i++) {
+    struct token_between_brackets *group =
+        vector_at(process->between_brackets_vec, i);
+    *group = lex_process_brackets_at(process, i);
+  }
+  uint32_t pending = (uint32_t)shift->bracket_offset;
+  for (int i = g1; i < shift->bracket_from; i++) {
+    struct token_between_brackets *group =
+        vector_at(process->between_brackets_vec, i);
+    group->first -= shift->count;
+    group->last -= shift->count;
+    group->start -= pending;
+    group->end -= pending;
+  }
+}
+
+/**
+ * @brief 重新计算受编辑影响的最外层括号，其余括号的平移记入process->shift
+ *
+ * @param from 被替换的第一个token
+ * @param old_end 被替换的旧token到此为止（不含）
+ * @param count_delta token数的变化
+ * @param delta 源码长度的变化
+ * @param size 编辑后的源码长度
+ */
+static void lex_relex_brackets(struct lex_process *process, int from,
+                               int old_end, int count_delta, long delta,
+                               size_t size) {
+  struct vector *groups = process->between_brackets_vec;
+  int total_groups = vector_count(groups);
+
+  // '('、')'或括号内的token落在[from, old_end)中的括号需要重新计算
+  int g0 = 0;
+  int high = total_groups;
+  while (g0 < high) {
+    int mid = (g0 + high) / 2;
+    if (lex_process_brackets_at(process, mid).last + 1 < from) {
+      g0 = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  int g1 = g0;
+  while (g1 < total_groups &&
+         lex_process_brackets_at(process, g1).first - 1 < old_end) {
+    g1++;
+  }
+
+  int scan_from = from;
+  int scan_end = old_end;
+  if (g0 < g1) {
+    struct token_between_brackets first = lex_process_brackets_at(process, g0);
+    struct token_between_brackets last =
+        lex_process_brackets_at(process, g1 - 1);
+    if (first.first - 1 < scan_from) {
+      scan_from = first.first - 1;
+    }
+    if (last.last + 2 > scan_end) {
+      scan_end = last.last + 2;
+    }
+  }
+  scan_end += count_delta;
+  int total = vector_count(process->token_vec);
+  if (scan_end > total) {
+    scan_end = total;
+  }
+
+  lexer_relex_rebase_brackets(process, g0, g1);
+  vector_erase_range(groups, g0, g1 - g0);
+
+  // 起点不在任何括号内，深度从0开始；空括号不在旁表中，结尾处可能仍在
+  // 这样的括号内，继续扫描到它的')'
+  struct vector *fresh = vector_create(sizeof(struct token_between_brackets));
+  struct token_between_brackets open = {};
+  int depth = 0;
+  int i = scan_from;
+  for (; i < total && (i < scan_end || depth > 0); i++) {
+    struct token *token = lexer_token_at(process->token_vec, i);
+    int paren = lex_token_paren_delta(token);
+    if (paren > 0 && 0 == depth++) {
+      open.first = i + 1;
+      open.start = lex_process_token_offset(process, i) + 1;
+    } else if (paren < 0 && depth > 0 && 0 == --depth) {
+      open.last = i - 1;
+      open.end = lex_process_token_offset(process, i);
+      if (open.first <= open.last) {
+        vector_push(fresh, &open);
+      }
+    }
+  }
+  if (depth > 0 && i == total) {
+    // 未闭合的括号一直延续到输入结尾
+    open.last = total - 1;
+    open.end = size;
+    if (open.first <= open.last) {
+      vector_push(fresh, &open);
+    }
+  }
+
+  vector_insert(groups, fresh, g0);
+  process->shift.bracket_from = g0 + vector_count(fresh);
+  process->shift.count += count_delta;
+  process->shift.bracket_offset += delta;
+  vector_free(fresh);
+}
+
+/**
+ * @brief 源码编辑后增量更新token_vec
+ * 从编辑处之前第二个token开始重新分析，一旦新token与平移后的旧token
+ * 位置、内容相同且括号深度一致，其后的旧token仍然有效，停止分析并拼接
+ *
+ * @param process token偏移对应编辑前的源码
+ * @param source 编辑后的完整源码
+ * @param size
+ * @param edit
+ * @return int
+ */
+int lex_relex(struct lex_process *process, const char *source, size_t size,
+              struct lex_edit *edit) {
+  struct vector *token_vec = process->token_vec;
+  int total = vector_count(token_vec);
+  long delta = (long)edit->inserted - (long)edit->removed;
+
+  // 编辑处之前的token可能被延长，再往前退一个，前一个token作为上下文
+  int restart = lexer_first_token_at(process, edit->offset + 1) - 2;
+  if (restart < 0) {
+    restart = 0;
+  }
+  // 读运算符时'..'会退回一个点，紧邻的运算符要一起重新分析
+  while (restart > 0 && lexer_operator_adjacent(token_vec, restart)) {
+    restart--;
+  }
+  size_t start = restart > 0 ? lex_process_token_offset(process, restart) : 0;
+
+  // 只有完全位于删除区间之后的旧token才可能复用
+  int old = lexer_first_token_at(process, edit->offset + edit->removed);
+  int old_depth = 0;
+  for (int i = restart; i < old; i++) {
+    old_depth += lex_token_paren_delta(lexer_token_at(token_vec, i));
+  }
+
+  struct lex_process *relex =
+      lex_process_create_for_memory(process->compiler, source, size);
+  relex->memory.offset = start;
+  relex->offset = start;
+  relex->current_expression_count = LEX_EXPRESSION_BASE;
+  relex->pos.filename = process->pos.filename;
+
+  // 起点前的token决定空白标记、#include<...>等上下文
+  struct token context = {};
+  bool has_context = restart > 0;
+  if (has_context) {
+    context = *lexer_token_at(token_vec, restart - 1);
+    context.offset = lex_process_token_offset(process, restart - 1);
+    lexer_push_token(relex, &context);
+  }
+  // 起点处的换行、预处理指令状态由旧token得出
+  bool elide = lexer_elide_trivia(process);
+  if (elide && has_context) {
+    relex->newline_pending =
+        lexer_token_at(token_vec, restart)->flags & TOKEN_FLAG_NEWLINE;
+    relex->in_directive = lexer_in_directive(process, restart - 1);
+  }
+
+  size_t edit_end = edit->offset + edit->inserted;
+  int new_depth = 0;
+  int sync = total;
+  struct token *token = read_next_token(relex);
+  while (token) {
+    if (token->offset >= edit_end) {
+      while (old < total &&
+             lex_process_token_offset(process, old) + delta < token->offset) {
+        old_depth += lex_token_paren_delta(lexer_token_at(token_vec, old));
+        old++;
+      }
+      struct token *old_token =
+          old < total ? lexer_token_at(token_vec, old) : NULL;
+      if (old_token &&
+          lex_process_token_offset(process, old) + delta == token->offset &&
+          new_depth == old_depth && lexer_token_equal(token, old_token) &&
+          (!elide || lexer_relex_trivia_equal(relex, token, process, old))) {
+        sync = old;
+        break;
+      }
+    }
+    new_depth += lex_token_paren_delta(token);
+    lexer_push_token(relex, token);
+    token = read_next_token(relex);
+  }
+
+  // 上下文token只带回起点处的空白标记
+  struct vector *fresh = relex->token_vec;
+  int from = restart;
+  if (has_context) {
+    struct token *first = vector_at(fresh, 0);
+    lexer_token_at(token_vec, restart - 1)->flags = first->flags;
+    vector_pop_at(fresh, 0);
+  }
+
+  // 其后的旧token不逐个平移，只记入process->shift，读取时再加上
+  lexer_relex_rebase_tokens(process, from, sync);
+  vector_erase_range(token_vec, from, sync - from);
+  vector_insert(token_vec, fresh, from);
+  process->shift.token_from = from + vector_count(fresh);
+  process->shift.offset += delta;
+  int count_delta = vector_count(fresh) - (sync - from);
+  lex_relex_brackets(process, from, sync, count_delta, delta, size);
+  lex_process_free(relex);
+
+  // 行首索引归lex_process所有，第一次编辑时按新源码建立
+  if (!process->lines) {
+    process->lines = calloc(1, sizeof(struct line_index));
+    line_index_init(process->lines);
+    line_index_build(process->lines, source, size);
+  } else {
+    line_index_edit(process->lines, source, edit->offset, edit->removed,
+                    edit->inserted);
+  }
+  return LEXICAL_ANALYSISI_ALL_OK;
+}
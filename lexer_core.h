@@ -0,0 +1,743 @@
+/*
+ * 词法分析器的核心部分，不是普通头文件：lexer.c为每种输入方式包含一次，
+ * 包含前用以下宏给出读字符原语，函数名加上LEX_CORE_NAME后缀，原语在各实例中内联
+ *   LEX_CORE_NAME                     函数名后缀
+ *   LEX_CORE_NEXT_CHAR(process)       读入一个字符
+ *   LEX_CORE_PEEK_CHAR(process)       查看下一个字符
+ *   LEX_CORE_PUSH_CHAR(process, c)    退回刚读入的字符
+ *   LEX_CORE_REMAINING(process, len)  连续内存的剩余数据，流式输入为NULL
+ *   LEX_CORE_SKIP(process, len)       跳过批量扫描过的字节
+ * 包含结束时这些宏被取消定义
+ */
+
+#define peekc LEX_CORE_FN(peekc)
+#define pushc LEX_CORE_FN(pushc)
+#define nextc LEX_CORE_FN(nextc)
+#define lexer_remaining LEX_CORE_FN(lexer_remaining)
+#define lexer_skip LEX_CORE_FN(lexer_skip)
+#define assert_next_char LEX_CORE_FN(assert_next_char)
+#define lexer_skip_blank LEX_CORE_FN(lexer_skip_blank)
+#define lex_number_begin LEX_CORE_FN(lex_number_begin)
+#define lex_number_peek LEX_CORE_FN(lex_number_peek)
+#define lex_number_next LEX_CORE_FN(lex_number_next)
+#define lex_number_finish LEX_CORE_FN(lex_number_finish)
+#define lex_number_digits LEX_CORE_FN(lex_number_digits)
+#define lex_number_exponent LEX_CORE_FN(lex_number_exponent)
+#define lex_number_integer_suffix LEX_CORE_FN(lex_number_integer_suffix)
+#define token_make_number LEX_CORE_FN(token_make_number)
+#define token_make_string LEX_CORE_FN(token_make_string)
+#define read_op LEX_CORE_FN(read_op)
+#define read_op_from LEX_CORE_FN(read_op_from)
+#define token_make_operator_or_string LEX_CORE_FN(token_make_operator_or_string)
+#define token_make_symbol LEX_CORE_FN(token_make_symbol)
+#define token_make_identifier_or_keyword LEX_CORE_FN(token_make_identifier_or_keyword)
+#define token_make_one_line_comment LEX_CORE_FN(token_make_one_line_comment)
+#define token_make_multi_line_comment LEX_CORE_FN(token_make_multi_line_comment)
+#define handle_comment LEX_CORE_FN(handle_comment)
+#define token_make_quote LEX_CORE_FN(token_make_quote)
+#define token_make_newline LEX_CORE_FN(token_make_newline)
+#define read_next_token LEX_CORE_FN(read_next_token)
+#define lex_tokens LEX_CORE_FN(lex_tokens)
+
+static char peekc(struct lex_process *process) {
+  return LEX_CORE_PEEK_CHAR(process);
+}
+
+static void pushc(struct lex_process *process, char c) {
+  LEX_CORE_PUSH_CHAR(process, c);
+  process->offset--;
+}
+
+/**
+ * @brief 从文件中读下一个
+ *
+ * @return char
+ */
+static char nextc(struct lex_process *process) {
+  char c = LEX_CORE_NEXT_CHAR(process);
+  // 只记录偏移，行列号需要时再由行首索引算出
+  process->offset++;
+  return c;
+}
+
+/**
+ * @brief 输入位于连续内存时返回剩余数据，供批量扫描使用
+ *
+ * @param len 剩余字节数
+ * @return const char* 流式输入返回NULL，只能逐字符读取
+ */
+static const char *lexer_remaining(struct lex_process *process, size_t *len) {
+  return LEX_CORE_REMAINING(process, len);
+}
+
+/**
+ * @brief 跳过批量扫描过的len个字节，效果等同于调用len次nextc
+ */
+static void lexer_skip(struct lex_process *process, size_t len) {
+  LEX_CORE_SKIP(process, len);
+  process->offset += len;
+}
+
+static char assert_next_char(struct lex_process *process, char c) {
+  char next_c = nextc(process);
+  assert(c == next_c);
+  return next_c;
+}
+
+/**
+ * @brief 一次跳过一整段空格、制表符，前一个token只标记一次空白
+ */
+static void lexer_skip_blank(struct lex_process *process) {
+  struct token *last_token = lexer_last_token(process);
+  if (last_token) {
+    last_token->flags |= TOKEN_FLAG_WHITESPACE;
+  }
+
+  nextc(process);
+  size_t len = 0;
+  const char *p = lexer_remaining(process, &len);
+  if (p) {
+    // 单个空格最常见，后面还有空白时才批量扫描
+    if (len && (' ' == p[0] || '\t' == p[0])) {
+      lexer_skip(process, lex_scan_blank(p, len));
+    }
+    return;
+  }
+
+  for (char c = peekc(process); ' ' == c || '\t' == c; c = peekc(process)) {
+    nextc(process);
+  }
+}
+
+/*----------func used for make number token-----------*/
+/**
+ * @brief 开始读数字，以'.'开头时'.'已经读入
+ */
+static void lex_number_begin(struct lex_process *process,
+                             struct lex_number_cursor *cursor,
+                             bool leading_dot) {
+  struct buffer *buffer = lexer_token_buffer(process);
+  if (leading_dot) {
+    buffer_write(buffer, '.');
+  }
+  cursor->process = process;
+  cursor->p = lexer_remaining(process, &cursor->len);
+  cursor->pos = 0;
+}
+
+static char lex_number_peek(struct lex_number_cursor *cursor) {
+  if (cursor->p) {
+    return cursor->pos < cursor->len ? cursor->p[cursor->pos] : EOF;
+  }
+  return peekc(cursor->process);
+}
+
+static void lex_number_next(struct lex_number_cursor *cursor) {
+  if (cursor->p) {
+    cursor->pos++;
+    return;
+  }
+  buffer_write(cursor->process->token_buffer, nextc(cursor->process));
+}
+
+/**
+ * @brief 读完数字，连续内存时跳过扫描过的字节
+ */
+static void lex_number_finish(struct lex_number_cursor *cursor) {
+  if (cursor->p) {
+    lexer_skip(cursor->process, cursor->pos);
+  }
+}
+
+/**
+ * @brief 读入一串数字，整数值和浮点数的有效数字在同一趟中累加
+ *
+ * @param base 进制，二进制、八进制也读入到9为止，由invalid报告
+ * @param fraction 小数部分，只计入有效数字
+ * @return int 读入的数字个数
+ */
+static int lex_number_digits(struct lex_number_cursor *cursor,
+                             struct lex_number *number, int base,
+                             bool fraction) {
+  int scale = 16 == base ? 16 : 10;
+  int shift = 16 == base ? 4 : 1;
+  int digits = 0;
+  for (int d = lex_digit_value(lex_number_peek(cursor)); d < scale;
+       d = lex_digit_value(lex_number_peek(cursor))) {
+    lex_number_next(cursor);
+    digits++;
+    number->invalid |= d >= base;
+    if (!fraction) {
+      number->overflow |=
+          __builtin_mul_overflow(number->value, base, &number->value);
+      number->overflow |=
+          __builtin_add_overflow(number->value, d, &number->value);
+    }
+
+    if (number->mantissa <= (~0ULL - 15) / scale) {
+      number->mantissa = number->mantissa * scale + d;
+      number->exponent -= fraction ? shift : 0;
+    } else {
+      // 放不下的数字只改变数量级
+      number->exponent += fraction ? 0 : shift;
+      number->inexact |= 0 != d;
+    }
+  }
+  return digits;
+}
+
+/**
+ * @brief 读指数部分e+10、p-3，'e'、'p'已读入
+ */
+static int lex_number_exponent(struct lex_number_cursor *cursor) {
+  char c = lex_number_peek(cursor);
+  bool negative = '-' == c;
+  if ('+' == c || '-' == c) {
+    lex_number_next(cursor);
+  }
+
+  int exponent = 0;
+  int digits = 0;
+  for (c = lex_number_peek(cursor); c >= '0' && c <= '9';
+       c = lex_number_peek(cursor)) {
+    lex_number_next(cursor);
+    digits++;
+    // 足以溢出或下溢，更大的指数不再累加
+    if (exponent < 100000) {
+      exponent = exponent * 10 + (c - '0');
+    }
+  }
+  if (!digits) {
+    lexer_error(cursor->process, "The exponent has no digits.\n");
+  }
+  return negative ? -exponent : exponent;
+}
+
+/**
+ * @brief 读整数后缀u、l、ll及其组合，如ULL、lu
+ */
+static int lex_number_integer_suffix(struct lex_number_cursor *cursor) {
+  int type = NUMBER_TYPE_NORMAL;
+  bool is_unsigned = false;
+  bool is_long = false;
+  for (;;) {
+    char c = lex_number_peek(cursor);
+    if (('u' == c || 'U' == c) && !is_unsigned) {
+      lex_number_next(cursor);
+      is_unsigned = true;
+    } else if (('l' == c || 'L' == c) && !is_long) {
+      lex_number_next(cursor);
+      is_long = true;
+      type = NUMBER_TYPE_LONG;
+      if (c == lex_number_peek(cursor)) {
+        lex_number_next(cursor);
+        type = NUMBER_TYPE_LONG_LONG;
+      }
+    } else {
+      break;
+    }
+  }
+  return is_unsigned ? type | NUMBER_TYPE_FLAG_UNSIGNED : type;
+}
+
+/**
+ * @brief 单趟读入整数或浮点数，不构造中间字串
+ * 处理：123、0x7F、0b101、017、1.5e-3、.5f、0x1.8p3、10ULL
+ *
+ * @param leading_dot 以'.'开头的浮点数，'.'已读入
+ */
+static struct token *token_make_number(struct lex_process *process,
+                                       bool leading_dot) {
+  struct lex_number_cursor cursor;
+  lex_number_begin(process, &cursor, leading_dot);
+  struct lex_number number = {};
+  int base = 10;
+  if (!leading_dot && '0' == lex_number_peek(&cursor)) {
+    lex_number_next(&cursor);
+    char c = lex_number_peek(&cursor);
+    if ('x' == c || 'X' == c) {
+      lex_number_next(&cursor);
+      base = 16;
+    } else if ('b' == c || 'B' == c) {
+      lex_number_next(&cursor);
+      base = 2;
+    } else {
+      // 0本身也按八进制读
+      base = 8;
+    }
+  }
+
+  bool hex = 16 == base;
+  bool floating = leading_dot;
+  int digits =
+      leading_dot ? 0 : lex_number_digits(&cursor, &number, base, false);
+  char c = lex_number_peek(&cursor);
+  if (leading_dot || (2 != base && '.' == c)) {
+    if (!leading_dot) {
+      lex_number_next(&cursor);
+    }
+    floating = true;
+    digits += lex_number_digits(&cursor, &number, base, true);
+    c = lex_number_peek(&cursor);
+  }
+
+  if ((16 == base || 2 == base) && !digits) {
+    lexer_error(process, hex ? "This is not a valid hexadecimal number.\n"
+                             : "This is not a valid binary number.\n");
+  }
+
+  bool has_exponent = hex ? ('p' == c || 'P' == c)
+                          : (2 != base && ('e' == c || 'E' == c));
+  if (has_exponent) {
+    lex_number_next(&cursor);
+    floating = true;
+    number.exponent += lex_number_exponent(&cursor);
+    c = lex_number_peek(&cursor);
+  } else if (hex && floating) {
+    lexer_error(process,
+                "A hexadecimal floating constant requires an exponent.\n");
+  }
+
+  if (!floating && number.invalid) {
+    lexer_error(process, 2 == base ? "This is not a valid binary number.\n"
+                                   : "This is not a valid octal number.\n");
+  }
+  if (!floating && number.overflow) {
+    lexer_error(process, "This integer constant is too large.\n");
+  }
+
+  // 整数也接受f、d后缀，按浮点数处理
+  int type = NUMBER_TYPE_DOUBLE;
+  if ('f' == c || 'F' == c) {
+    lex_number_next(&cursor);
+    type = NUMBER_TYPE_FLOAT;
+  } else if ('d' == c || 'D' == c) {
+    lex_number_next(&cursor);
+  } else if (floating && ('l' == c || 'L' == c)) {
+    lex_number_next(&cursor);
+    type = NUMBER_TYPE_LONG_DOUBLE;
+  } else if (!floating) {
+    type = lex_number_integer_suffix(&cursor);
+  }
+
+  struct token token = {.type = TOKEN_TYPE_NUMBER, .num_type = type};
+  if (!floating && NUMBER_TYPE_FLOAT == type) {
+    token.dnum = (float)number.value;
+  } else if (!floating && NUMBER_TYPE_DOUBLE == type) {
+    token.dnum = (double)number.value;
+  } else if (!floating) {
+    token.llnum = number.value;
+  } else if (NUMBER_TYPE_FLOAT == type) {
+    token.dnum = (float)lex_number_double(&cursor, &number, hex, true);
+  } else {
+    token.dnum = lex_number_double(&cursor, &number, hex, false);
+  }
+
+  lex_number_finish(&cursor);
+  return token_create(process, &token);
+}
+
+static struct token *token_make_string(struct lex_process *process,
+                                       char start_delim, char end_delimi) {
+  struct buffer *buf = lexer_token_buffer(process);
+  // 处理左引号 "
+  assert(nextc(process) == start_delim);
+  char c = nextc(process);
+  for (; c != end_delimi && c != EOF; c = nextc(process)) {
+    // 处理转义字符
+    if ('\\' == c) {
+      continue;
+    }
+    buffer_write(buf, c);
+  }
+  // 未闭合的字串读到了输入结尾，EOF不占偏移
+  if (EOF == c) {
+    process->offset--;
+  }
+
+  return token_create(process,
+                      &(struct token){.type = TOKEN_TYPE_STRING,
+                                      .sval = lexer_token_text(process, buf)});
+}
+
+/*----------func used for make operator token-----------*/
+/**
+ * @brief 按最长匹配读入运算符，每次只需peek一个字符决定是否继续
+ *
+ * @param first 已读入的第一个字符
+ * @return int 运算符编号
+ */
+static int read_op_from(struct lex_process *process, char first) {
+  int state = operator_dfa_next(OPERATOR_DFA_START, first);
+  if (OPERATOR_DFA_START == state) {
+    lexer_error(process, "The operator %c is not valid\n", first);
+  }
+
+  for (int next = operator_dfa_next(state, peekc(process)); next;
+       next = operator_dfa_next(state, peekc(process))) {
+    nextc(process);
+    state = next;
+  }
+
+  int op = operator_dfa_accept(state);
+  if (OPERATOR_NONE == op) {
+    // 只有".."会停在非接受状态，退回第二个点
+    pushc(process, '.');
+    op = OPERATOR_DOT;
+  }
+
+  return op;
+}
+
+static int read_op(struct lex_process *process) {
+  return read_op_from(process, nextc(process));
+}
+
+static struct token *token_make_operator_or_string(
+    struct lex_process *process) {
+  char op = peekc(process);
+  if ('<' == op) {  // 处理类似 #include<abc.h>
+    struct token *last_token = lexer_last_token(process);
+    if (token_is_keyword_id(last_token, KEYWORD_INCLUDE)) {
+      return token_make_string(process, '<', '>');
+    }
+  }
+  if ('.' == op) {  // 处理类似 .5
+    nextc(process);
+    if (isdigit(peekc(process))) {
+      return token_make_number(process, true);
+    }
+    return token_make_operator(process, read_op_from(process, '.'));
+  }
+
+  return token_make_operator(process, read_op(process));
+}
+
+/*----------func used for make symbol token-----------*/
+static struct token *token_make_symbol(struct lex_process *process) {
+  char c = nextc(process);
+  if (')' == c) {
+    lex_finish_expression(process);
+  } else if ('#' == c && lexer_elide_trivia(process) &&
+             !process->in_directive &&
+             (process->newline_pending || !lexer_last_token(process))) {
+    // 行首的'#'开始预处理指令
+    process->in_directive = true;
+  }
+
+  struct token *token = token_create(
+      process, &(struct token){.type = TOKEN_TYPE_SYMBOL, .cval = c});
+  return token;
+}
+
+/*----------func used for make identifier token-----------*/
+static struct token *token_make_identifier_or_keyword(
+    struct lex_process *process) {
+  const char *str = NULL;
+  size_t len = 0;
+  const char *p = lexer_remaining(process, &len);
+  if (p) {
+    // 连续内存直接在源数据上查表和驻留，不经过临时缓冲
+    len = lex_scan_identifier(p, len);
+    str = p;
+    lexer_skip(process, len);
+  } else {
+    struct buffer *buffer = lexer_token_buffer(process);
+    char c = 0;
+    LEX_GETC_IF(process, buffer, c,
+                (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                    (c >= '0' && c <= '9') || (c == '_'));
+    str = buffer_ptr(buffer);
+    len = buffer->len;
+  }
+
+  // 检查是否是关键字，关键字只记录编号，无需驻留
+  int keyword = keyword_lookup(str, len);
+  if (KEYWORD_NONE != keyword) {
+    return token_create(process,
+                        &(struct token){.type = TOKEN_TYPE_KEYWORD,
+                                        .sval = keyword_name(keyword),
+                                        .keyword = keyword});
+  }
+
+  // 相同拼写只在驻留表中保存一份，哈希值保存在驻留字串之前
+  str = intern(process->compiler->interns, str, len);
+  return token_create(
+      process, &(struct token){.type = TOKEN_TYPE_IDENTIFIER, .sval = str});
+}
+
+/*----------func used for make comment token-----------*/
+static struct token *token_make_one_line_comment(
+    struct lex_process *process) {
+  size_t len = 0;
+  const char *p = lexer_remaining(process, &len);
+  if (p) {
+    len = lex_scan_line(p, len);
+    lexer_skip(process, len);
+    if (lexer_elide_trivia(process)) {
+      return lexer_elide_comment(process);
+    }
+    return token_create(
+        process,
+        &(struct token){.type = TOKEN_TYPE_COMMENT,
+                        .sval = arena_strndup(process->compiler->arena, p,
+                                              len)});
+  }
+
+  if (lexer_elide_trivia(process)) {
+    for (char c = peekc(process); c != '\n' && c != EOF; c = peekc(process)) {
+      nextc(process);
+    }
+    return lexer_elide_comment(process);
+  }
+
+  struct buffer *buffer = lexer_token_buffer(process);
+  char c = 0;
+  LEX_GETC_IF(process, buffer, c, (c != '\n' && c != EOF));
+  return token_create(
+      process, &(struct token){.type = TOKEN_TYPE_COMMENT,
+                               .sval = lexer_token_text(process, buffer)});
+}
+
+static struct token *token_make_multi_line_comment(
+    struct lex_process *process) {
+  size_t len = 0;
+  const char *p = lexer_remaining(process, &len);
+  if (p) {
+    size_t n = lex_scan_comment_end(p, len);
+    if (n == len) {
+      lexer_skip(process, len);
+      lexer_error(process, "You did not close this multiline comment.\n");
+    }
+    // 连同结尾的"*/"一起跳过
+    lexer_skip(process, n + 2);
+    if (lexer_elide_trivia(process)) {
+      return lexer_elide_comment(process);
+    }
+    return token_create(
+        process,
+        &(struct token){.type = TOKEN_TYPE_COMMENT,
+                        .sval = arena_strndup(process->compiler->arena, p,
+                                              n)});
+  }
+
+  if (lexer_elide_trivia(process)) {
+    // 只找结束符，不保存内容
+    for (char c = nextc(process); !('*' == c && '/' == peekc(process));
+         c = nextc(process)) {
+      if (EOF == c) {
+        lexer_error(process, "You did not close this multiline comment.\n");
+      }
+    }
+    nextc(process);
+    return lexer_elide_comment(process);
+  }
+
+  struct buffer *buffer = lexer_token_buffer(process);
+  char c = 0;
+  while (1) {
+    LEX_GETC_IF(process, buffer, c, c != '*' && c != EOF);
+    if (EOF == c) {
+      lexer_error(process, "You did not close this multiline comment.\n");
+    } else if ('*' == c) {
+      // 继续读一个
+      nextc(process);
+      if ('/' == peekc(process)) {
+        // skip '/'
+        nextc(process);
+        break;
+      }
+      // 不构成结束符的'*'属于注释内容
+      buffer_write(buffer, '*');
+    }
+  }
+  return token_create(
+      process, &(struct token){.type = TOKEN_TYPE_COMMENT,
+                               .sval = lexer_token_text(process, buffer)});
+}
+
+static struct token *handle_comment(struct lex_process *process) {
+  char c = peekc(process);
+  if ('/' == c) {
+    nextc(process);
+    if ('/' == peekc(process)) {
+      nextc(process);
+      return token_make_one_line_comment(process);
+    } else if ('*' == peekc(process)) {
+      nextc(process);
+      return token_make_multi_line_comment(process);
+    }
+
+    // '/'可作为注释开头，单个出现则是除法运算符，故放在这里处理
+    // 从已读入的'/'继续识别运算符，如 / 或 /=
+    return token_make_operator(process, read_op_from(process, '/'));
+  }
+  return NULL;
+}
+
+/*----------func used for make quote token-----------*/
+static struct token *token_make_quote(struct lex_process *process) {
+  // 读入并判断左单引号
+  assert_next_char(process, '\'');
+  // 读入''中的内容  ASCII：0-255
+  char c = nextc(process);
+  if ('\\' == c) {
+    // 处理转义字符  '\\t'
+    c = nextc(process);
+    c = lex_get_escaped_char(c);
+  }
+
+  // 判断右单引号
+  if ('\'' != nextc(process)) {
+    lexer_error(
+        process,
+        "You open a quote ' but did not close it with a ' character.\n");
+  }
+
+  return token_create(
+      process, &(struct token){.type = TOKEN_TYPE_NUMBER, .cval = c});
+}
+
+/*----------func used for make newline token-----------*/
+static struct token *token_make_newline(struct lex_process *process) {
+  nextc(process);
+  if (!lexer_elide_trivia(process)) {
+    return token_create(process, &(struct token){.type = TOKEN_TYPE_NEWLINE});
+  }
+
+  // 预处理指令之外的换行只记在下一个token上
+  struct token *token = NULL;
+  if (process->in_directive) {
+    process->in_directive = lexer_continues_line(lexer_last_token(process),
+                                                 process->token_start);
+    token =
+        token_create(process, &(struct token){.type = TOKEN_TYPE_NEWLINE});
+  }
+  process->newline_pending = true;
+  return token;
+}
+
+
+/**
+ * @brief 读下一个token，空白在循环内整段跳过，不再递归
+ *
+ * @return struct token* 读到输入结尾返回NULL
+ */
+static struct token *read_next_token(struct lex_process *process) {
+  struct token *token = NULL;
+#ifdef LEX_COMPUTED_GOTO
+  static void *const lex_states[LEX_CLASS_COUNT] = {
+      [LEX_CLASS_INVALID] = &&LEX_STATE(LEX_CLASS_INVALID),
+      [LEX_CLASS_END] = &&LEX_STATE(LEX_CLASS_END),
+      [LEX_CLASS_BLANK] = &&LEX_STATE(LEX_CLASS_BLANK),
+      [LEX_CLASS_NEWLINE] = &&LEX_STATE(LEX_CLASS_NEWLINE),
+      [LEX_CLASS_DIGIT] = &&LEX_STATE(LEX_CLASS_DIGIT),
+      [LEX_CLASS_IDENTIFIER] = &&LEX_STATE(LEX_CLASS_IDENTIFIER),
+      [LEX_CLASS_OPERATOR] = &&LEX_STATE(LEX_CLASS_OPERATOR),
+      [LEX_CLASS_SLASH] = &&LEX_STATE(LEX_CLASS_SLASH),
+      [LEX_CLASS_SYMBOL] = &&LEX_STATE(LEX_CLASS_SYMBOL),
+      [LEX_CLASS_STRING] = &&LEX_STATE(LEX_CLASS_STRING),
+      [LEX_CLASS_QUOTE] = &&LEX_STATE(LEX_CLASS_QUOTE),
+  };
+#endif
+
+  for (;;) {
+    char c = peekc(process);
+    process->token_start = process->offset;
+    LEX_DISPATCH(lex_char_class[(unsigned char)c]) {
+      LEX_STATE(LEX_CLASS_BLANK):
+        lexer_skip_blank(process);
+        continue;
+
+      LEX_STATE(LEX_CLASS_DIGIT):
+        return token_make_number(process, false);
+
+      LEX_STATE(LEX_CLASS_IDENTIFIER):
+        return token_make_identifier_or_keyword(process);
+
+      LEX_STATE(LEX_CLASS_OPERATOR):
+        return token_make_operator_or_string(process);
+
+      // 注释或除法运算符
+      LEX_STATE(LEX_CLASS_SLASH):
+        token = handle_comment(process);
+        if (token) {
+          return token;
+        }
+        // 省略的注释
+        continue;
+
+      LEX_STATE(LEX_CLASS_SYMBOL):
+        return token_make_symbol(process);
+
+      LEX_STATE(LEX_CLASS_STRING):
+        return token_make_string(process, '"', '"');
+
+      LEX_STATE(LEX_CLASS_QUOTE):
+        return token_make_quote(process);
+
+      LEX_STATE(LEX_CLASS_NEWLINE):
+        token = token_make_newline(process);
+        if (token) {
+          return token;
+        }
+        continue;
+
+      LEX_STATE(LEX_CLASS_END):
+        /* 读到文件尾表示顺利完成分析 */
+        return NULL;
+
+      LEX_STATE(LEX_CLASS_INVALID):
+        // 读到不能识别的字符
+        lexer_error(process, "Unexpected token\n");
+        return NULL;
+    }
+  }
+}
+
+/**
+ * @brief 读完剩余输入，token依次写入token_vec或环形缓冲
+ */
+static void lex_tokens(struct lex_process *process) {
+  struct token *token = read_next_token(process);
+  while (token) {
+    lexer_push_token(process, token);
+    token = read_next_token(process);
+  }
+}
+
+#undef peekc
+#undef pushc
+#undef nextc
+#undef lexer_remaining
+#undef lexer_skip
+#undef assert_next_char
+#undef lexer_skip_blank
+#undef lex_number_begin
+#undef lex_number_peek
+#undef lex_number_next
+#undef lex_number_finish
+#undef lex_number_digits
+#undef lex_number_exponent
+#undef lex_number_integer_suffix
+#undef token_make_number
+#undef token_make_string
+#undef read_op
+#undef read_op_from
+#undef token_make_operator_or_string
+#undef token_make_symbol
+#undef token_make_identifier_or_keyword
+#undef token_make_one_line_comment
+#undef token_make_multi_line_comment
+#undef handle_comment
+#undef token_make_quote
+#undef token_make_newline
+#undef read_next_token
+#undef lex_tokens
+
+#undef LEX_CORE_NAME
+#undef LEX_CORE_NEXT_CHAR
+#undef LEX_CORE_PEEK_CHAR
+#undef LEX_CORE_PUSH_CHAR
+#undef LEX_CORE_REMAINING
+#undef LEX_CORE_SKIP
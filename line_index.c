@@ -0,0 +1,155 @@
+#include "compiler.h"
+#include "helpers/vector.h"
+#include <stdlib.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * 行首偏移索引：line_starts[i]为第i+1行第一个字符的字节偏移
+ * token只保存偏移，报错或调试输出时再二分查找出行列号
+ */
+void line_index_init(struct line_index *lines)
+{
+    lines->line_starts = vector_create(sizeof(uint32_t));
+    uint32_t first = 0;
+    vector_push(lines->line_starts, &first);
+    lines->complete = false;
+}
+
+void line_index_free(struct line_index *lines)
+{
+    if(lines->line_starts){
+        vector_free(lines->line_starts);
+        lines->line_starts = NULL;
+    }
+}
+
+/**
+ * @brief 逐字符读取时记录换行，重复读入（回退后再读）的换行只记录一次
+ * 
+ * @param lines 
+ * @param offset 换行符之后的偏移，即新一行的行首
+ */
+void line_index_add_line(struct line_index *lines, size_t offset)
+{
+    uint32_t *last = vector_back(lines->line_starts);
+    if(offset > *last){
+        uint32_t start = offset;
+        vector_push(lines->line_starts, &start);
+    }
+}
+
+/**
+ * @brief 一次性扫描整段数据中的换行，SSE2每次比较16字节
+ * 
+ * @param lines 
+ * @param data 
+ * @param size 
+ */
+void line_index_build(struct line_index *lines, const char *data, size_t size)
+{
+    vector_clear(lines->line_starts);
+    uint32_t first = 0;
+    vector_push(lines->line_starts, &first);
+    vector_reserve(lines->line_starts, size / 32 + 1);
+
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i newline = _mm_set1_epi8('\n');
+    for(; i + 16 <= size; i += 16){
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        while(mask){
+            uint32_t start = i + __builtin_ctz(mask) + 1;
+            vector_push(lines->line_starts, &start);
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for(; i < size; i++){
+        if('\n' == data[i]){
+            uint32_t start = i + 1;
+            vector_push(lines->line_starts, &start);
+        }
+    }
+
+    lines->complete = true;
+}
+
+/**
+ * @brief 第一个行首大于offset的行
+ */
+static int line_index_upper_bound(struct line_index *lines, size_t offset)
+{
+    uint32_t *starts = vector_data_ptr(lines->line_starts);
+    int low = 0;
+    int high = vector_count(lines->line_starts);
+    while(low < high){
+        int mid = (low + high) / 2;
+        if(starts[mid] <= offset){
+            low = mid + 1;
+        }
+        else{
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief 源码编辑后更新索引：旧源码[offset, offset + removed)被替换为新源码data中的[offset, offset + inserted)
+ * 
+ * @param lines 
+ * @param data 编辑后的源码
+ * @param offset 
+ * @param removed 
+ * @param inserted 
+ */
+void line_index_edit(struct line_index *lines, const char *data, size_t offset, size_t removed, size_t inserted)
+{
+    // 删除的换行之后的行首随之消失
+    int first = line_index_upper_bound(lines, offset);
+    int last = line_index_upper_bound(lines, offset + removed);
+    vector_erase_range(lines->line_starts, first, last - first);
+
+    uint32_t *starts = vector_data_ptr(lines->line_starts);
+    for(int i = first; i < vector_count(lines->line_starts); i++){
+        starts[i] = starts[i] + inserted - removed;
+    }
+
+    struct vector *added = vector_create(sizeof(uint32_t));
+    for(size_t i = offset; i < offset + inserted; i++){
+        if('\n' == data[i]){
+            uint32_t start = i + 1;
+            vector_push(added, &start);
+        }
+    }
+    vector_insert(lines->line_starts, added, first);
+    vector_free(added);
+}
+
+/**
+ * @brief 二分查找偏移所在的行
+ * 
+ * @param lines 
+ * @param offset 
+ * @return struct pos 行列号均从1开始，不含文件名
+ */
+struct pos line_index_pos(struct line_index *lines, size_t offset)
+{
+    uint32_t *starts = vector_data_ptr(lines->line_starts);
+    int low = 0;
+    int high = vector_count(lines->line_starts) - 1;
+    while(low < high){
+        int mid = (low + high + 1) / 2;
+        if(starts[mid] <= offset){
+            low = mid;
+        }
+        else{
+            high = mid - 1;
+        }
+    }
+
+    return (struct pos){.line = low + 1, .col = offset - starts[low] + 1};
+}
\ No newline at end of file
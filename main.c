@@ -1,17 +1,175 @@
 #include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
 #include "compiler.h"
+#include "helpers/vector.h"
+#include "helpers/threadpool.h"
 
-int main()
+/**
+ * 用法：main [-j workers] [-t] [-T] [-c] [-p] [-e] [-a] file.c ... @response_file
+ * 每个输入文件作为一个任务交给线程池并行编译，未给出文件时编译./test.c
+ *   -t 以文本形式输出token到标准输出
+ *   -T 以二进制格式输出token到输出文件
+ *   -c 使用TOKEN_CACHE_DIR中的token缓存，源文件内容未变时跳过词法分析
+ *   -p 大文件切块，多个线程同时做词法分析
+ *   -e 不生成注释token，换行只在预处理指令内生成token，其余记为下一个token的标记
+ *   -a 以缩进的文本形式输出语法树
+ */
+
+struct compile_job
+{
+    const char* filename;
+    char* out_filename;
+    int flags;
+    int result;
+    double elapsed_ms;
+};
+
+static double driver_now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/**
+ * @brief 输出文件名为去掉扩展名的输入文件名，如./test.c -> ./test
+ * 
+ * @param filename 
+ * @return char* 
+ */
+static char* driver_out_filename(const char* filename)
 {
-     int res = compile_file("./test.c", "./test", 0);
-     if(res == COMPILER_FILE_COMPILED_OK){
-        printf("Compile done!\n");
-     }
-     else if(res == COMPILER_FAILED_WITH_ERRORS){
-        printf("Compile failed!\n");
-     }
-     else{
-        printf("Unknown reason.\n");
-     }
+    const char* slash = strrchr(filename, '/');
+    const char* dot = strrchr(filename, '.');
+    size_t len = strlen(filename);
+    if(dot && (!slash || dot > slash) && dot != filename){
+        len = dot - filename;
+    }
+
+    char* out = malloc(len + sizeof(".out"));
+    memcpy(out, filename, len);
+    out[len] = 0x00;
+    // 没有扩展名时避免覆盖输入文件
+    if(len == strlen(filename)){
+        strcat(out, ".out");
+    }
+    return out;
+}
+
+/**
+ * @brief 读取响应文件，文件名之间以空白分隔
+ * 
+ * @param path 
+ * @param files 
+ * @return int 0成功
+ */
+static int driver_read_response_file(const char* path, struct vector* files)
+{
+    FILE* fp = fopen(path, "r");
+    if(!fp){
+        fprintf(stderr, "Cannot open response file %s\n", path);
+        return -1;
+    }
+
+    char name[4096];
+    while(fscanf(fp, "%4095s", name) == 1){
+        char* filename = strdup(name);
+        vector_push(files, &filename);
+    }
+    fclose(fp);
     return 0;
 }
+
+static void compile_job_run(void* arg)
+{
+    struct compile_job* job = arg;
+    double start = driver_now_ms();
+    job->result = compile_file(job->filename, job->out_filename, job->flags);
+    job->elapsed_ms = driver_now_ms() - start;
+}
+
+static const char* compile_job_status(struct compile_job* job)
+{
+    if(job->result == COMPILER_FILE_COMPILED_OK){
+        return "Compile done!";
+    }
+    else if(job->result == COMPILER_FAILED_WITH_ERRORS){
+        return "Compile failed!";
+    }
+    return "Unknown reason.";
+}
+
+int main(int argc, char** argv)
+{
+    struct vector* files = vector_create(sizeof(char*));
+    int total_workers = 0;
+    int flags = 0;
+    for(int i = 1; i < argc; i++){
+        if(S_EQ(argv[i], "-j") && i + 1 < argc){
+            total_workers = atoi(argv[++i]);
+        }
+        else if(S_EQ(argv[i], "-t")){
+            flags |= COMPILE_PROCESS_FLAG_DUMP_TOKENS;
+        }
+        else if(S_EQ(argv[i], "-T")){
+            flags |= COMPILE_PROCESS_FLAG_DUMP_TOKENS_BINARY;
+        }
+        else if(S_EQ(argv[i], "-c")){
+            flags |= COMPILE_PROCESS_FLAG_TOKEN_CACHE;
+        }
+        else if(S_EQ(argv[i], "-p")){
+            flags |= COMPILE_PROCESS_FLAG_PARALLEL_LEX;
+        }
+        else if(S_EQ(argv[i], "-e")){
+            flags |= COMPILE_PROCESS_FLAG_ELIDE_TRIVIA;
+        }
+        else if(S_EQ(argv[i], "-a")){
+            flags |= COMPILE_PROCESS_FLAG_DUMP_AST;
+        }
+        else if('@' == argv[i][0]){
+            if(driver_read_response_file(argv[i] + 1, files) != 0){
+                return 1;
+            }
+        }
+        else{
+            vector_push(files, &argv[i]);
+        }
+    }
+
+    if(vector_empty(files)){
+        char* filename = "./test.c";
+        vector_push(files, &filename);
+    }
+
+    int total_files = vector_count(files);
+    struct compile_job* jobs = calloc(total_files, sizeof(struct compile_job));
+    double start = driver_now_ms();
+
+    // 线程数默认等于CPU核数，空闲线程从其他线程的队列中窃取任务
+    struct threadpool* pool = threadpool_create(total_workers);
+    for(int i = 0; i < total_files; i++){
+        jobs[i].filename = *(char**)vector_at(files, i);
+        jobs[i].out_filename = driver_out_filename(jobs[i].filename);
+        jobs[i].flags = flags;
+        threadpool_submit(pool, compile_job_run, &jobs[i]);
+    }
+    total_workers = pool->total_workers;
+    threadpool_free(pool);
+
+    double wall_ms = driver_now_ms() - start;
+    int failed = 0;
+    for(int i = 0; i < total_files; i++){
+        printf("%s: %s (%.2f ms)\n", jobs[i].filename, compile_job_status(&jobs[i]), jobs[i].elapsed_ms);
+        if(jobs[i].result != COMPILER_FILE_COMPILED_OK){
+            failed++;
+        }
+        free(jobs[i].out_filename);
+    }
+    printf("%d files, %d failed, %d workers, wall time %.2f ms\n", total_files, failed, total_workers, wall_ms);
+
+    free(jobs);
+    vector_free(files);
+    return failed ? 1 : 0;
+}
\ No newline at end of file
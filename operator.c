@@ -0,0 +1,169 @@
+#include "compiler.h"
+
+/**
+ * 运算符按最长匹配（maximal munch）识别：
+ * 每个运算符的前缀都是DFA的一个状态，状态OPERATOR_STATE(op)接受运算符op，
+ * 读入字符后查表得到下一状态，查不到转移即停止，无需回退字符
+ * ".."不是运算符，只作为"..."的中间状态
+ */
+#define OPERATOR_STATE(op) ((op) + 1)
+#define OPERATOR_STATE_DOT_DOT (OPERATOR_COUNT + 1)
+#define OPERATOR_STATE_COUNT (OPERATOR_COUNT + 2)
+
+static const unsigned char operator_transitions[OPERATOR_STATE_COUNT][128] = {
+    [OPERATOR_DFA_START] = {
+        ['!'] = OPERATOR_STATE(OPERATOR_NOT),
+        ['%'] = OPERATOR_STATE(OPERATOR_MODULO),
+        ['&'] = OPERATOR_STATE(OPERATOR_AMPERSAND),
+        ['('] = OPERATOR_STATE(OPERATOR_LPAREN),
+        ['*'] = OPERATOR_STATE(OPERATOR_STAR),
+        ['+'] = OPERATOR_STATE(OPERATOR_PLUS),
+        [','] = OPERATOR_STATE(OPERATOR_COMMA),
+        ['-'] = OPERATOR_STATE(OPERATOR_MINUS),
+        ['.'] = OPERATOR_STATE(OPERATOR_DOT),
+        ['/'] = OPERATOR_STATE(OPERATOR_DIVIDE),
+        ['<'] = OPERATOR_STATE(OPERATOR_LESS),
+        ['='] = OPERATOR_STATE(OPERATOR_ASSIGN),
+        ['>'] = OPERATOR_STATE(OPERATOR_GREATER),
+        ['?'] = OPERATOR_STATE(OPERATOR_QUESTION),
+        ['['] = OPERATOR_STATE(OPERATOR_LBRACKET),
+        ['^'] = OPERATOR_STATE(OPERATOR_XOR),
+        ['|'] = OPERATOR_STATE(OPERATOR_OR),
+        ['~'] = OPERATOR_STATE(OPERATOR_BITWISE_NOT),
+    },
+    [OPERATOR_STATE(OPERATOR_NOT)] = {
+        ['='] = OPERATOR_STATE(OPERATOR_NOT_EQUAL),
+    },
+    [OPERATOR_STATE(OPERATOR_MODULO)] = {
+        ['='] = OPERATOR_STATE(OPERATOR_MOD_ASSIGN),
+    },
+    [OPERATOR_STATE(OPERATOR_AMPERSAND)] = {
+        ['&'] = OPERATOR_STATE(OPERATOR_LOGICAL_AND),
+        ['='] = OPERATOR_STATE(OPERATOR_AND_ASSIGN),
+    },
+    [OPERATOR_STATE(OPERATOR_STAR)] = {
+        ['='] = OPERATOR_STATE(OPERATOR_MUL_ASSIGN),
+    },
+    [OPERATOR_STATE(OPERATOR_PLUS)] = {
+        ['+'] = OPERATOR_STATE(OPERATOR_INCREMENT),
+        ['='] = OPERATOR_STATE(OPERATOR_ADD_ASSIGN),
+    },
+    [OPERATOR_STATE(OPERATOR_MINUS)] = {
+        ['-'] = OPERATOR_STATE(OPERATOR_DECREMENT),
+        ['='] = OPERATOR_STATE(OPERATOR_SUB_ASSIGN),
+        ['>'] = OPERATOR_STATE(OPERATOR_ARROW),
+    },
+    [OPERATOR_STATE(OPERATOR_DOT)] = {
+        ['.'] = OPERATOR_STATE_DOT_DOT,
+    },
+    [OPERATOR_STATE(OPERATOR_DIVIDE)] = {
+        ['='] = OPERATOR_STATE(OPERATOR_DIV_ASSIGN),
+    },
+    [OPERATOR_STATE(OPERATOR_LESS)] = {
+        ['<'] = OPERATOR_STATE(OPERATOR_LEFT_SHIFT),
+        ['='] = OPERATOR_STATE(OPERATOR_LESS_EQUAL),
+    },
+    [OPERATOR_STATE(OPERATOR_ASSIGN)] = {
+        ['='] = OPERATOR_STATE(OPERATOR_EQUAL),
+    },
+    [OPERATOR_STATE(OPERATOR_GREATER)] = {
+        ['='] = OPERATOR_STATE(OPERATOR_GREATER_EQUAL),
+        ['>'] = OPERATOR_STATE(OPERATOR_RIGHT_SHIFT),
+    },
+    [OPERATOR_STATE(OPERATOR_XOR)] = {
+        ['='] = OPERATOR_STATE(OPERATOR_XOR_ASSIGN),
+    },
+    [OPERATOR_STATE(OPERATOR_OR)] = {
+        ['='] = OPERATOR_STATE(OPERATOR_OR_ASSIGN),
+        ['|'] = OPERATOR_STATE(OPERATOR_LOGICAL_OR),
+    },
+    [OPERATOR_STATE_DOT_DOT] = {
+        ['.'] = OPERATOR_STATE(OPERATOR_ELLIPSIS),
+    },
+    [OPERATOR_STATE(OPERATOR_LEFT_SHIFT)] = {
+        ['='] = OPERATOR_STATE(OPERATOR_LEFT_SHIFT_ASSIGN),
+    },
+    [OPERATOR_STATE(OPERATOR_RIGHT_SHIFT)] = {
+        ['='] = OPERATOR_STATE(OPERATOR_RIGHT_SHIFT_ASSIGN),
+    },
+};
+
+static const char *const operator_names[OPERATOR_COUNT] = {
+    [OPERATOR_LPAREN] = "(",
+    [OPERATOR_LBRACKET] = "[",
+    [OPERATOR_ARROW] = "->",
+    [OPERATOR_DOT] = ".",
+    [OPERATOR_NOT] = "!",
+    [OPERATOR_BITWISE_NOT] = "~",
+    [OPERATOR_INCREMENT] = "++",
+    [OPERATOR_DECREMENT] = "--",
+    [OPERATOR_MINUS] = "-",
+    [OPERATOR_STAR] = "*",
+    [OPERATOR_AMPERSAND] = "&",
+    [OPERATOR_DIVIDE] = "/",
+    [OPERATOR_MODULO] = "%",
+    [OPERATOR_PLUS] = "+",
+    [OPERATOR_LEFT_SHIFT] = "<<",
+    [OPERATOR_RIGHT_SHIFT] = ">>",
+    [OPERATOR_LESS] = "<",
+    [OPERATOR_GREATER] = ">",
+    [OPERATOR_LESS_EQUAL] = "<=",
+    [OPERATOR_GREATER_EQUAL] = ">=",
+    [OPERATOR_EQUAL] = "==",
+    [OPERATOR_NOT_EQUAL] = "!=",
+    [OPERATOR_XOR] = "^",
+    [OPERATOR_OR] = "|",
+    [OPERATOR_LOGICAL_AND] = "&&",
+    [OPERATOR_LOGICAL_OR] = "||",
+    [OPERATOR_QUESTION] = "?",
+    [OPERATOR_ASSIGN] = "=",
+    [OPERATOR_ADD_ASSIGN] = "+=",
+    [OPERATOR_SUB_ASSIGN] = "-=",
+    [OPERATOR_MUL_ASSIGN] = "*=",
+    [OPERATOR_DIV_ASSIGN] = "/=",
+    [OPERATOR_MOD_ASSIGN] = "%=",
+    [OPERATOR_LEFT_SHIFT_ASSIGN] = "<<=",
+    [OPERATOR_RIGHT_SHIFT_ASSIGN] = ">>=",
+    [OPERATOR_AND_ASSIGN] = "&=",
+    [OPERATOR_XOR_ASSIGN] = "^=",
+    [OPERATOR_OR_ASSIGN] = "|=",
+    [OPERATOR_COMMA] = ",",
+    [OPERATOR_ELLIPSIS] = "...",
+};
+
+/**
+ * @brief 状态转移
+ * 
+ * @param state 当前状态，0为初始状态
+ * @param c 下一字符
+ * @return int 下一状态，0表示没有转移
+ */
+int operator_dfa_next(int state, char c)
+{
+    if((unsigned char)c >= 128){
+        return OPERATOR_DFA_START;
+    }
+    return operator_transitions[state][(unsigned char)c];
+}
+
+/**
+ * @brief 状态对应的运算符
+ * 
+ * @param state 
+ * @return int 运算符编号，非接受状态返回OPERATOR_NONE
+ */
+int operator_dfa_accept(int state)
+{
+    if(state <= OPERATOR_DFA_START || state > OPERATOR_COUNT){
+        return OPERATOR_NONE;
+    }
+    return state - 1;
+}
+
+const char *operator_name(int op)
+{
+    if(op < 0 || op >= OPERATOR_COUNT){
+        return NULL;
+    }
+    return operator_names[op];
+}
\ No newline at end of file
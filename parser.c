@@ -0,0 +1,1431 @@
+#include<stdarg.h>
+#include<setjmp.h>
+#include<stdlib.h>
+#include<string.h>
+#include "compiler.h"
+#include "helpers/intern.h"
+#include "helpers/vector.h"
+
+/**
+ * 递归下降语法分析，表达式按优先级循环(Pratt)分析：
+ * 1. 直接按下标读compile_process->token_vec，注释、换行和预处理指令在取token时跳过
+ * 2. 节点存入compile_process->ast的平行数组，以编号互相引用；子节点先于父节点分配，
+ *    经next_sibling链成表，父节点只记第一个子节点，不需要临时的子节点数组
+ * 3. 没有预处理器，typedef名只认本文件中定义的；未知的名字后面紧跟声明符时也按类型名处理
+ */
+
+// 二元运算符的优先级，越大结合越紧，0表示不是二元运算符
+enum
+{
+    PARSER_PRECEDENCE_NONE,
+    PARSER_PRECEDENCE_COMMA,
+    PARSER_PRECEDENCE_ASSIGN,
+    PARSER_PRECEDENCE_TERNARY,
+    PARSER_PRECEDENCE_LOGICAL_OR,
+    PARSER_PRECEDENCE_LOGICAL_AND,
+    PARSER_PRECEDENCE_BITWISE_OR,
+    PARSER_PRECEDENCE_XOR,
+    PARSER_PRECEDENCE_BITWISE_AND,
+    PARSER_PRECEDENCE_EQUALITY,
+    PARSER_PRECEDENCE_RELATIONAL,
+    PARSER_PRECEDENCE_SHIFT,
+    PARSER_PRECEDENCE_ADDITIVE,
+    PARSER_PRECEDENCE_MULTIPLICATIVE
+};
+
+static const uint8_t parser_precedence[OPERATOR_COUNT] = {
+    [OPERATOR_COMMA] = PARSER_PRECEDENCE_COMMA,
+    [OPERATOR_ASSIGN] = PARSER_PRECEDENCE_ASSIGN,
+    [OPERATOR_ADD_ASSIGN] = PARSER_PRECEDENCE_ASSIGN,
+    [OPERATOR_SUB_ASSIGN] = PARSER_PRECEDENCE_ASSIGN,
+    [OPERATOR_MUL_ASSIGN] = PARSER_PRECEDENCE_ASSIGN,
+    [OPERATOR_DIV_ASSIGN] = PARSER_PRECEDENCE_ASSIGN,
+    [OPERATOR_MOD_ASSIGN] = PARSER_PRECEDENCE_ASSIGN,
+    [OPERATOR_LEFT_SHIFT_ASSIGN] = PARSER_PRECEDENCE_ASSIGN,
+    [OPERATOR_RIGHT_SHIFT_ASSIGN] = PARSER_PRECEDENCE_ASSIGN,
+    [OPERATOR_AND_ASSIGN] = PARSER_PRECEDENCE_ASSIGN,
+    [OPERATOR_XOR_ASSIGN] = PARSER_PRECEDENCE_ASSIGN,
+    [OPERATOR_OR_ASSIGN] = PARSER_PRECEDENCE_ASSIGN,
+    [OPERATOR_QUESTION] = PARSER_PRECEDENCE_TERNARY,
+    [OPERATOR_LOGICAL_OR] = PARSER_PRECEDENCE_LOGICAL_OR,
+    [OPERATOR_LOGICAL_AND] = PARSER_PRECEDENCE_LOGICAL_AND,
+    [OPERATOR_OR] = PARSER_PRECEDENCE_BITWISE_OR,
+    [OPERATOR_XOR] = PARSER_PRECEDENCE_XOR,
+    [OPERATOR_AMPERSAND] = PARSER_PRECEDENCE_BITWISE_AND,
+    [OPERATOR_EQUAL] = PARSER_PRECEDENCE_EQUALITY,
+    [OPERATOR_NOT_EQUAL] = PARSER_PRECEDENCE_EQUALITY,
+    [OPERATOR_LESS] = PARSER_PRECEDENCE_RELATIONAL,
+    [OPERATOR_GREATER] = PARSER_PRECEDENCE_RELATIONAL,
+    [OPERATOR_LESS_EQUAL] = PARSER_PRECEDENCE_RELATIONAL,
+    [OPERATOR_GREATER_EQUAL] = PARSER_PRECEDENCE_RELATIONAL,
+    [OPERATOR_LEFT_SHIFT] = PARSER_PRECEDENCE_SHIFT,
+    [OPERATOR_RIGHT_SHIFT] = PARSER_PRECEDENCE_SHIFT,
+    [OPERATOR_PLUS] = PARSER_PRECEDENCE_ADDITIVE,
+    [OPERATOR_MINUS] = PARSER_PRECEDENCE_ADDITIVE,
+    [OPERATOR_STAR] = PARSER_PRECEDENCE_MULTIPLICATIVE,
+    [OPERATOR_DIVIDE] = PARSER_PRECEDENCE_MULTIPLICATIVE,
+    [OPERATOR_MODULO] = PARSER_PRECEDENCE_MULTIPLICATIVE
+};
+
+// 声明所在的位置
+enum
+{
+    PARSER_SCOPE_GLOBAL,
+    PARSER_SCOPE_LOCAL,
+    PARSER_SCOPE_MEMBER
+};
+
+// typedef名集合的初始容量，2的幂
+#define PARSER_TYPEDEFS_INITIAL_CAPACITY 64
+// 括号中的声明符先接在这个占位类型上，如int (*fp)(int)
+#define PARSER_DATATYPE_HOLE UINT32_MAX
+// 预估每个节点对应的token数，用于预分配节点数组
+#define PARSER_ESTIMATED_TOKENS_PER_NODE 2
+
+struct parse_process
+{
+    struct compile_process* compiler;
+    struct ast* ast;
+    struct token* tokens;
+    int count;
+    // 当前token的下标，总是停在有效token上，读完时等于count
+    int index;
+    // 出错时跳回parse，只放弃当前文件
+    jmp_buf error_jump;
+
+    // typedef名，元素为驻留字串，开放寻址，容量为2的幂
+    const char** typedefs;
+    size_t typedef_capacity;
+    size_t typedef_count;
+
+    // 词法分析不作为关键字的inline、_Static_assert的驻留字串，文件中没有出现时为NULL
+    const char* inline_word;
+    const char* static_assert_word;
+};
+
+/*----------func used for report errors-----------*/
+static void parser_error(struct parse_process* parser, const char* msg, ...)
+{
+    char message[256];
+    va_list args;
+    va_start(args, msg);
+    vsnprintf(message, sizeof(message), msg, args);
+    va_end(args);
+
+    // 行列号由出错token的偏移算出
+    struct compile_process* compiler = parser->compiler;
+    size_t offset = parser->index < parser->count ? parser->tokens[parser->index].offset : compiler->cfile.size;
+    compiler_report_error(compiler, offset, "%s", message);
+    longjmp(parser->error_jump, 1);
+}
+
+/*----------func used for read tokens-----------*/
+/**
+ * @brief 下标index的'#'位于行首，开始一条预处理指令
+ */
+static bool parser_is_directive(struct parse_process* parser, int index)
+{
+    struct token* token = &parser->tokens[index];
+    if(TOKEN_TYPE_SYMBOL != token->type || '#' != token->cval){
+        return false;
+    }
+    if(token->flags & TOKEN_FLAG_NEWLINE){
+        return true;
+    }
+
+    int prev = index - 1;
+    while(prev >= 0 && TOKEN_TYPE_COMMENT == parser->tokens[prev].type){
+        prev--;
+    }
+    return prev < 0 || TOKEN_TYPE_NEWLINE == parser->tokens[prev].type;
+}
+
+/**
+ * @brief 跳过从index开始的预处理指令，到不是续行的换行为止
+ *
+ * @return int 指令之后的下标
+ */
+static int parser_skip_directive(struct parse_process* parser, int index)
+{
+    for(index++; index < parser->count; index++){
+        struct token* token = &parser->tokens[index];
+        if(TOKEN_TYPE_NEWLINE != token->type){
+            continue;
+        }
+
+        struct token* prev = &parser->tokens[index - 1];
+        bool continued = TOKEN_TYPE_SYMBOL == prev->type && '\\' == prev->cval && prev->offset + 1 == token->offset;
+        if(!continued){
+            return index + 1;
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief 从index开始第一个有效token的下标，跳过注释、换行和预处理指令
+ */
+static int parser_skip_trivia(struct parse_process* parser, int index)
+{
+    while(index < parser->count){
+        int type = parser->tokens[index].type;
+        if(TOKEN_TYPE_NEWLINE == type || TOKEN_TYPE_COMMENT == type){
+            index++;
+        }
+        else if(parser_is_directive(parser, index)){
+            index = parser_skip_directive(parser, index);
+        }
+        else{
+            break;
+        }
+    }
+    return index;
+}
+
+static struct token* parser_token_at(struct parse_process* parser, int index)
+{
+    return index < parser->count ? &parser->tokens[index] : NULL;
+}
+
+static struct token* parser_token(struct parse_process* parser)
+{
+    return parser_token_at(parser, parser->index);
+}
+
+/**
+ * @brief 当前token之后第一个有效token的下标
+ */
+static int parser_next_index(struct parse_process* parser, int index)
+{
+    return index < parser->count ? parser_skip_trivia(parser, index + 1) : index;
+}
+
+/**
+ * @brief 读过当前token
+ *
+ * @return int 读过的token的下标
+ */
+static int parser_advance(struct parse_process* parser)
+{
+    int index = parser->index;
+    parser->index = parser_next_index(parser, index);
+    return index;
+}
+
+static bool parser_is_symbol(struct token* token, char c)
+{
+    return token && TOKEN_TYPE_SYMBOL == token->type && c == token->cval;
+}
+
+static bool parser_is_operator(struct token* token, int op)
+{
+    return token && TOKEN_TYPE_OPERATOR == token->type && op == token->op;
+}
+
+static bool parser_accept_symbol(struct parse_process* parser, char c)
+{
+    if(!parser_is_symbol(parser_token(parser), c)){
+        return false;
+    }
+    parser_advance(parser);
+    return true;
+}
+
+static bool parser_accept_operator(struct parse_process* parser, int op)
+{
+    if(!parser_is_operator(parser_token(parser), op)){
+        return false;
+    }
+    parser_advance(parser);
+    return true;
+}
+
+static int parser_expect_symbol(struct parse_process* parser, char c)
+{
+    if(!parser_is_symbol(parser_token(parser), c)){
+        parser_error(parser, "Expecting the symbol %c\n", c);
+    }
+    return parser_advance(parser);
+}
+
+static int parser_expect_identifier(struct parse_process* parser)
+{
+    struct token* token = parser_token(parser);
+    if(!token || TOKEN_TYPE_IDENTIFIER != token->type){
+        parser_error(parser, "Expecting an identifier\n");
+    }
+    return parser_advance(parser);
+}
+
+/*----------func used for typedef names-----------*/
+static bool parser_is_typedef(struct parse_process* parser, const char* name)
+{
+    size_t mask = parser->typedef_capacity - 1;
+    for(size_t slot = intern_string_hash(name) & mask; parser->typedefs[slot]; slot = (slot + 1) & mask){
+        // 驻留字串直接比较指针
+        if(parser->typedefs[slot] == name){
+            return true;
+        }
+    }
+    return false;
+}
+
+static void parser_add_typedef(struct parse_process* parser, const char* name)
+{
+    if(parser_is_typedef(parser, name)){
+        return;
+    }
+
+    // 装载率超过一半时扩容并重新插入
+    if((parser->typedef_count + 1) * 2 > parser->typedef_capacity){
+        const char** old = parser->typedefs;
+        size_t old_capacity = parser->typedef_capacity;
+        parser->typedef_capacity *= 2;
+        parser->typedefs = calloc(parser->typedef_capacity, sizeof(const char*));
+        parser->typedef_count = 0;
+        for(size_t i = 0; i < old_capacity; i++){
+            if(old[i]){
+                parser_add_typedef(parser, old[i]);
+            }
+        }
+        free(old);
+    }
+
+    size_t mask = parser->typedef_capacity - 1;
+    size_t slot = intern_string_hash(name) & mask;
+    while(parser->typedefs[slot]){
+        slot = (slot + 1) & mask;
+    }
+    parser->typedefs[slot] = name;
+    parser->typedef_count++;
+}
+
+/*----------func used for make nodes-----------*/
+/**
+ * @brief 分配节点，子节点已由调用者链好
+ *
+ * @param first_child 第一个子节点，没有时为NODE_ID_NONE
+ * @return uint32_t 节点编号
+ */
+static uint32_t parser_node(struct parse_process* parser, int type, int token_index, uint32_t first_child)
+{
+    return ast_node(parser->ast, type, token_index, first_child);
+}
+
+static uint32_t parser_node_2(struct parse_process* parser, int type, int token_index, uint32_t first, uint32_t second)
+{
+    parser->ast->next_sibling[first] = second;
+    return parser_node(parser, type, token_index, first);
+}
+
+static uint32_t parser_node_3(struct parse_process* parser, int type, int token_index, uint32_t first, uint32_t second, uint32_t third)
+{
+    parser->ast->next_sibling[second] = third;
+    return parser_node_2(parser, type, token_index, first, second);
+}
+
+static uint32_t parser_blank(struct parse_process* parser)
+{
+    return parser_node(parser, NODE_TYPE_BLANK, parser->index, NODE_ID_NONE);
+}
+
+// 正在收集的不定个数的子节点，first为NODE_ID_NONE时为空
+struct parser_list
+{
+    uint32_t first;
+    uint32_t last;
+};
+
+static void parser_list_push(struct parse_process* parser, struct parser_list* list, uint32_t node)
+{
+    if(NODE_ID_NONE == list->first){
+        list->first = node;
+    }
+    else{
+        parser->ast->next_sibling[list->last] = node;
+    }
+    list->last = node;
+}
+
+static uint32_t parser_datatype(struct parse_process* parser, int type, uint32_t base)
+{
+    return ast_datatype(parser->ast, type, base);
+}
+
+/**
+ * @brief 类型表中的类型，再分配类型后指针失效，只用于立即读写
+ */
+static struct datatype* parser_datatype_at(struct parse_process* parser, uint32_t id)
+{
+    return &parser->ast->datatypes[id];
+}
+
+/*----------func used for recognize types-----------*/
+static bool parser_is_specifier_keyword(int keyword)
+{
+    switch(keyword){
+        case KEYWORD_VOID:
+        case KEYWORD_CHAR:
+        case KEYWORD_INT:
+        case KEYWORD_FLOAT:
+        case KEYWORD_DOUBLE:
+        case KEYWORD_SHORT:
+        case KEYWORD_LONG:
+        case KEYWORD_SIGNED:
+        case KEYWORD_UNSIGNED:
+        case KEYWORD_STRUCT:
+        case KEYWORD_UNION:
+        case KEYWORD_ENUM:
+        case KEYWORD_TYPEDEF:
+        case KEYWORD_AUTO:
+        case KEYWORD_STATIC:
+        case KEYWORD_REGISTER:
+        case KEYWORD_EXTERN:
+        case KEYWORD_CONST:
+        case KEYWORD_VOLATILE:
+        case KEYWORD_RESTRICT:
+        case KEYWORD_IGNORE_TYPECHECK:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool parser_is_identifier(struct token* token)
+{
+    return token && TOKEN_TYPE_IDENTIFIER == token->type;
+}
+
+/**
+ * @brief 下标index的标识符用作类型名
+ * 已知的typedef名；或者没有头文件时未知的名字，后面紧跟声明符，如size_t n、FILE* fp;
+ * 在类型转换的括号中，后面只有'*'和')'，如(FILE*)
+ */
+static bool parser_is_type_identifier(struct parse_process* parser, int index)
+{
+    struct token* token = parser_token_at(parser, index);
+    if(!parser_is_identifier(token)){
+        return false;
+    }
+    if(parser_is_typedef(parser, token->sval)){
+        return true;
+    }
+
+    int next = parser_next_index(parser, index);
+    struct token* next_token = parser_token_at(parser, next);
+    if(parser_is_identifier(next_token)){
+        return true;
+    }
+    if(!parser_is_operator(next_token, OPERATOR_STAR)){
+        return false;
+    }
+
+    while(parser_is_operator(next_token, OPERATOR_STAR)){
+        next = parser_next_index(parser, next);
+        next_token = parser_token_at(parser, next);
+    }
+    if(parser_is_symbol(next_token, ')')){
+        return true;
+    }
+    if(!parser_is_identifier(next_token)){
+        return false;
+    }
+
+    // a * b;、a * b = c;不是有意义的表达式语句，按声明处理
+    next_token = parser_token_at(parser, parser_next_index(parser, next));
+    return parser_is_symbol(next_token, ';') || parser_is_operator(next_token, OPERATOR_ASSIGN) ||
+           parser_is_operator(next_token, OPERATOR_COMMA) || parser_is_operator(next_token, OPERATOR_LBRACKET);
+}
+
+/**
+ * @brief 下标index处开始一个声明或类型名
+ */
+static bool parser_starts_type(struct parse_process* parser, int index)
+{
+    struct token* token = parser_token_at(parser, index);
+    if(token && TOKEN_TYPE_KEYWORD == token->type){
+        return parser_is_specifier_keyword(token->keyword);
+    }
+    return parser_is_type_identifier(parser, index);
+}
+
+
+/*----------func used for parse types-----------*/
+static uint32_t parser_expression(struct parse_process* parser, int min_precedence);
+static uint32_t parser_declaration(struct parse_process* parser, int scope);
+static uint32_t parser_parameter(struct parse_process* parser);
+static uint32_t parser_initializer(struct parse_process* parser);
+static uint32_t parser_body(struct parse_process* parser);
+static uint32_t parser_expression_statement(struct parse_process* parser);
+
+/**
+ * @brief struct、union、enum的标签，读过之后停在'{'或定义体之后
+ *
+ * @return uint32_t 类型编号
+ */
+static uint32_t parser_tag(struct parse_process* parser, int type)
+{
+    uint32_t datatype = parser_datatype(parser, type, DATATYPE_ID_NONE);
+    struct token* token = parser_token(parser);
+    if(parser_is_identifier(token)){
+        parser_datatype_at(parser, datatype)->name = token->sval;
+        parser_advance(parser);
+    }
+    return datatype;
+}
+
+/**
+ * @brief struct、union的标签和成员表
+ */
+static uint32_t parser_record(struct parse_process* parser, int type)
+{
+    uint32_t datatype = parser_tag(parser, type);
+    if(!parser_is_symbol(parser_token(parser), '{')){
+        return datatype;
+    }
+
+    int index = parser_advance(parser);
+    struct parser_list members = {};
+    while(!parser_accept_symbol(parser, '}')){
+        if(!parser_token(parser)){
+            parser_error(parser, "You did not close the struct body\n");
+        }
+        parser_list_push(parser, &members, parser_declaration(parser, PARSER_SCOPE_MEMBER));
+    }
+    uint32_t body = parser_node(parser, NODE_TYPE_BODY, index, members.first);
+    parser_datatype_at(parser, datatype)->node = body;
+    return datatype;
+}
+
+/**
+ * @brief enum的标签和枚举常量表
+ */
+static uint32_t parser_enum(struct parse_process* parser)
+{
+    uint32_t datatype = parser_tag(parser, DATATYPE_ENUM);
+    if(!parser_is_symbol(parser_token(parser), '{')){
+        return datatype;
+    }
+
+    int index = parser_advance(parser);
+    struct parser_list enumerators = {};
+    while(!parser_accept_symbol(parser, '}')){
+        int name = parser_expect_identifier(parser);
+        uint32_t value = NODE_ID_NONE;
+        if(parser_accept_operator(parser, OPERATOR_ASSIGN)){
+            value = parser_expression(parser, PARSER_PRECEDENCE_TERNARY);
+        }
+        parser_list_push(parser, &enumerators, parser_node(parser, NODE_TYPE_ENUMERATOR, name, value));
+
+        // 最后一个常量后可以有逗号
+        if(!parser_accept_operator(parser, OPERATOR_COMMA) && !parser_is_symbol(parser_token(parser), '}')){
+            parser_error(parser, "Expecting , or } in the enum body\n");
+        }
+    }
+    uint32_t body = parser_node(parser, NODE_TYPE_BODY, index, enumerators.first);
+    parser_datatype_at(parser, datatype)->node = body;
+    return datatype;
+}
+
+/**
+ * @brief 类型说明：存储类别、限定符和基本类型，顺序任意
+ *
+ * @param type_expected 参数、类型名的位置只能是类型，开头未知的名字都按typedef名处理，如(FILE*)、f(FILE* fp)
+ * @return uint32_t 类型编号，没有任何类型说明时返回DATATYPE_ID_NONE
+ */
+static uint32_t parser_specifiers(struct parse_process* parser, bool type_expected)
+{
+    uint32_t named = DATATYPE_ID_NONE;
+    int base = -1;
+    int longs = 0;
+    bool is_short = false;
+    bool any = false;
+    int flags = 0;
+    for(struct token* token = parser_token(parser); token; token = parser_token(parser)){
+        if(TOKEN_TYPE_IDENTIFIER == token->type){
+            if(token->sval == parser->inline_word){
+                parser_advance(parser);
+                any = true;
+                continue;
+            }
+            // 已有基本类型时标识符是声明符的名字
+            if(named || base >= 0 || is_short || longs || (flags & (DATATYPE_FLAG_SIGNED | DATATYPE_FLAG_UNSIGNED)) ||
+               !(type_expected || parser_is_type_identifier(parser, parser->index))){
+                break;
+            }
+            named = parser_datatype(parser, DATATYPE_TYPEDEF, DATATYPE_ID_NONE);
+            parser_datatype_at(parser, named)->name = token->sval;
+            parser_advance(parser);
+            any = true;
+            continue;
+        }
+        if(TOKEN_TYPE_KEYWORD != token->type || !parser_is_specifier_keyword(token->keyword)){
+            break;
+        }
+
+        int keyword = token->keyword;
+        parser_advance(parser);
+        any = true;
+        switch(keyword){
+            case KEYWORD_VOID:
+                base = DATATYPE_VOID;
+                break;
+            case KEYWORD_CHAR:
+                base = DATATYPE_CHAR;
+                break;
+            case KEYWORD_INT:
+                base = DATATYPE_INT;
+                break;
+            case KEYWORD_FLOAT:
+                base = DATATYPE_FLOAT;
+                break;
+            case KEYWORD_DOUBLE:
+                base = DATATYPE_DOUBLE;
+                break;
+            case KEYWORD_SHORT:
+                is_short = true;
+                break;
+            case KEYWORD_LONG:
+                longs++;
+                break;
+            case KEYWORD_SIGNED:
+                flags |= DATATYPE_FLAG_SIGNED;
+                break;
+            case KEYWORD_UNSIGNED:
+                flags |= DATATYPE_FLAG_UNSIGNED;
+                break;
+            case KEYWORD_STRUCT:
+                named = parser_record(parser, DATATYPE_STRUCT);
+                break;
+            case KEYWORD_UNION:
+                named = parser_record(parser, DATATYPE_UNION);
+                break;
+            case KEYWORD_ENUM:
+                named = parser_enum(parser);
+                break;
+            case KEYWORD_TYPEDEF:
+                flags |= DATATYPE_FLAG_TYPEDEF;
+                break;
+            case KEYWORD_AUTO:
+                flags |= DATATYPE_FLAG_AUTO;
+                break;
+            case KEYWORD_STATIC:
+                flags |= DATATYPE_FLAG_STATIC;
+                break;
+            case KEYWORD_REGISTER:
+                flags |= DATATYPE_FLAG_REGISTER;
+                break;
+            case KEYWORD_EXTERN:
+                flags |= DATATYPE_FLAG_EXTERN;
+                break;
+            case KEYWORD_CONST:
+                flags |= DATATYPE_FLAG_CONST;
+                break;
+            case KEYWORD_VOLATILE:
+                flags |= DATATYPE_FLAG_VOLATILE;
+                break;
+            case KEYWORD_RESTRICT:
+                flags |= DATATYPE_FLAG_RESTRICT;
+                break;
+            case KEYWORD_IGNORE_TYPECHECK:
+                flags |= DATATYPE_FLAG_IGNORE_TYPECHECK;
+                break;
+        }
+    }
+    if(!any){
+        return DATATYPE_ID_NONE;
+    }
+    if(named){
+        parser_datatype_at(parser, named)->flags |= flags;
+        return named;
+    }
+
+    // 只有修饰词时默认为int，如unsigned x、static x
+    int type = base >= 0 ? base : DATATYPE_INT;
+    if(is_short){
+        type = DATATYPE_SHORT;
+    }
+    else if(longs && DATATYPE_DOUBLE == type){
+        type = DATATYPE_LONG_DOUBLE;
+    }
+    else if(longs){
+        type = longs > 1 ? DATATYPE_LONG_LONG : DATATYPE_LONG;
+    }
+    uint32_t datatype = parser_datatype(parser, type, DATATYPE_ID_NONE);
+    parser_datatype_at(parser, datatype)->flags = flags;
+    return datatype;
+}
+
+/**
+ * @brief 函数参数表，'('已读入
+ *
+ * @param function 函数类型的编号，参数表写入它的node
+ */
+static void parser_parameters(struct parse_process* parser, uint32_t function)
+{
+    int index = parser->index;
+
+    // (void)表示没有参数
+    struct token* token = parser_token(parser);
+    if(token_is_keyword_id(token, KEYWORD_VOID) &&
+       parser_is_symbol(parser_token_at(parser, parser_next_index(parser, parser->index)), ')')){
+        parser_advance(parser);
+    }
+
+    struct parser_list params = {};
+    while(!parser_accept_symbol(parser, ')')){
+        if(parser_accept_operator(parser, OPERATOR_ELLIPSIS)){
+            parser_datatype_at(parser, function)->flags |= DATATYPE_FLAG_VARIADIC;
+            parser_expect_symbol(parser, ')');
+            break;
+        }
+
+        parser_list_push(parser, &params, parser_parameter(parser));
+        if(!parser_accept_operator(parser, OPERATOR_COMMA) && !parser_is_symbol(parser_token(parser), ')')){
+            parser_error(parser, "Expecting , or ) in the parameter list\n");
+        }
+    }
+    uint32_t list = parser_node(parser, NODE_TYPE_VARIABLE_LIST, index, params.first);
+    parser_datatype_at(parser, function)->node = list;
+}
+
+/**
+ * @brief 声明符之后的数组、函数后缀，从右往左作用，如int a[2][3]是2个int[3]
+ */
+static uint32_t parser_declarator_suffix(struct parse_process* parser, uint32_t base)
+{
+    if(parser_accept_operator(parser, OPERATOR_LBRACKET)){
+        uint32_t size = NODE_ID_NONE;
+        if(!parser_is_symbol(parser_token(parser), ']')){
+            size = parser_expression(parser, PARSER_PRECEDENCE_ASSIGN);
+        }
+        parser_expect_symbol(parser, ']');
+        uint32_t array = parser_datatype(parser, DATATYPE_ARRAY, parser_declarator_suffix(parser, base));
+        parser_datatype_at(parser, array)->node = size;
+        return array;
+    }
+    if(parser_accept_operator(parser, OPERATOR_LPAREN)){
+        uint32_t function = parser_datatype(parser, DATATYPE_FUNCTION, DATATYPE_ID_NONE);
+        parser_parameters(parser, function);
+        uint32_t result = parser_declarator_suffix(parser, base);
+        parser_datatype_at(parser, function)->base = result;
+        return function;
+    }
+    return base;
+}
+
+/**
+ * @brief 当前的'('包着一个声明符，如int (*fp)(int)，而不是参数表
+ */
+static bool parser_is_nested_declarator(struct parse_process* parser)
+{
+    int next = parser_next_index(parser, parser->index);
+    struct token* token = parser_token_at(parser, next);
+    return parser_is_operator(token, OPERATOR_STAR) ||
+           (parser_is_identifier(token) && !parser_is_type_identifier(parser, next));
+}
+
+/**
+ * @brief 声明符：指针、名字、数组和函数后缀，可以用括号嵌套
+ *
+ * @param base 类型说明
+ * @param name_index 名字的token下标，抽象声明符没有名字时为-1
+ * @return uint32_t 声明的完整类型
+ */
+static uint32_t parser_declarator(struct parse_process* parser, uint32_t base, int* name_index)
+{
+    while(parser_accept_operator(parser, OPERATOR_STAR)){
+        base = parser_datatype(parser, DATATYPE_POINTER, base);
+        // 指针自身的限定符，如char* const p
+        for(struct token* token = parser_token(parser); token && TOKEN_TYPE_KEYWORD == token->type; token = parser_token(parser)){
+            if(KEYWORD_CONST == token->keyword){
+                parser_datatype_at(parser, base)->flags |= DATATYPE_FLAG_CONST;
+            }
+            else if(KEYWORD_VOLATILE == token->keyword){
+                parser_datatype_at(parser, base)->flags |= DATATYPE_FLAG_VOLATILE;
+            }
+            else if(KEYWORD_RESTRICT == token->keyword){
+                parser_datatype_at(parser, base)->flags |= DATATYPE_FLAG_RESTRICT;
+            }
+            else{
+                break;
+            }
+            parser_advance(parser);
+        }
+    }
+
+    if(parser_is_operator(parser_token(parser), OPERATOR_LPAREN) && parser_is_nested_declarator(parser)){
+        // 括号外的后缀先作用：括号内先接在占位类型上，分析完后缀再把占位换成结果
+        parser_advance(parser);
+        uint32_t inner = parser_declarator(parser, PARSER_DATATYPE_HOLE, name_index);
+        parser_expect_symbol(parser, ')');
+        base = parser_declarator_suffix(parser, base);
+        if(PARSER_DATATYPE_HOLE == inner){
+            return base;
+        }
+
+        uint32_t link = inner;
+        while(parser_datatype_at(parser, link)->base != PARSER_DATATYPE_HOLE){
+            link = parser_datatype_at(parser, link)->base;
+        }
+        parser_datatype_at(parser, link)->base = base;
+        return inner;
+    }
+
+    *name_index = -1;
+    if(parser_is_identifier(parser_token(parser))){
+        *name_index = parser_advance(parser);
+    }
+    return parser_declarator_suffix(parser, base);
+}
+
+/**
+ * @brief 类型名，用于类型转换、sizeof和复合字面量
+ */
+static uint32_t parser_type_name(struct parse_process* parser)
+{
+    uint32_t type = parser_specifiers(parser, true);
+    if(!type){
+        parser_error(parser, "Expecting a type\n");
+    }
+
+    int name = -1;
+    type = parser_declarator(parser, type, &name);
+    if(name >= 0){
+        parser_error(parser, "A type name cannot declare %s\n", parser->tokens[name].sval);
+    }
+    return type;
+}
+
+static uint32_t parser_parameter(struct parse_process* parser)
+{
+    int start = parser->index;
+    uint32_t type = parser_specifiers(parser, true);
+    if(!type){
+        parser_error(parser, "Expecting a parameter type\n");
+    }
+
+    int name = -1;
+    type = parser_declarator(parser, type, &name);
+    uint32_t node = parser_node(parser, NODE_TYPE_VARIABLE, name >= 0 ? name : start, NODE_ID_NONE);
+    parser->ast->type_id[node] = type;
+    if(name < 0){
+        parser->ast->flags[node] |= NODE_FLAG_ANONYMOUS;
+    }
+    return node;
+}
+
+/*----------func used for parse expressions-----------*/
+static uint32_t parser_unary(struct parse_process* parser);
+
+static uint32_t parser_primary(struct parse_process* parser)
+{
+    struct token* token = parser_token(parser);
+    if(!token){
+        parser_error(parser, "Unexpected end of file in an expression\n");
+    }
+
+    switch(token->type){
+        case TOKEN_TYPE_NUMBER:
+            return parser_node(parser, NODE_TYPE_NUMBER, parser_advance(parser), NODE_ID_NONE);
+
+        case TOKEN_TYPE_IDENTIFIER:
+            return parser_node(parser, NODE_TYPE_IDENTIFIER, parser_advance(parser), NODE_ID_NONE);
+
+        case TOKEN_TYPE_STRING: {
+            uint32_t node = parser_node(parser, NODE_TYPE_STRING, parser_advance(parser), NODE_ID_NONE);
+            // 相邻的字串拼接为一个
+            for(token = parser_token(parser); token && TOKEN_TYPE_STRING == token->type; token = parser_token(parser)){
+                parser_advance(parser);
+            }
+            return node;
+        }
+
+        case TOKEN_TYPE_OPERATOR:
+            if(OPERATOR_LPAREN == token->op){
+                parser_advance(parser);
+                uint32_t node = parser_expression(parser, PARSER_PRECEDENCE_COMMA);
+                parser_expect_symbol(parser, ')');
+                return node;
+            }
+            break;
+    }
+    parser_error(parser, "Unexpected token in an expression\n");
+    return NODE_ID_NONE;
+}
+
+/**
+ * @brief 后缀运算：调用、下标、成员访问和后缀的++、--
+ */
+static uint32_t parser_postfix(struct parse_process* parser, uint32_t node)
+{
+    for(struct token* token = parser_token(parser); token && TOKEN_TYPE_OPERATOR == token->type; token = parser_token(parser)){
+        int index = parser->index;
+        int op = token->op;
+        switch(op){
+            case OPERATOR_LPAREN: {
+                parser_advance(parser);
+                struct parser_list args = {};
+                parser_list_push(parser, &args, node);
+                while(!parser_accept_symbol(parser, ')')){
+                    parser_list_push(parser, &args, parser_expression(parser, PARSER_PRECEDENCE_ASSIGN));
+                    if(!parser_accept_operator(parser, OPERATOR_COMMA) && !parser_is_symbol(parser_token(parser), ')')){
+                        parser_error(parser, "Expecting , or ) in the argument list\n");
+                    }
+                }
+                node = parser_node(parser, NODE_TYPE_CALL, index, args.first);
+                break;
+            }
+
+            case OPERATOR_LBRACKET: {
+                parser_advance(parser);
+                uint32_t subscript = parser_expression(parser, PARSER_PRECEDENCE_COMMA);
+                parser_expect_symbol(parser, ']');
+                node = parser_node_2(parser, NODE_TYPE_EXPRESSION, index, node, subscript);
+                parser->ast->op[node] = op;
+                break;
+            }
+
+            case OPERATOR_DOT:
+            case OPERATOR_ARROW: {
+                parser_advance(parser);
+                uint32_t member = parser_node(parser, NODE_TYPE_IDENTIFIER, parser_expect_identifier(parser), NODE_ID_NONE);
+                node = parser_node_2(parser, NODE_TYPE_EXPRESSION, index, node, member);
+                parser->ast->op[node] = op;
+                break;
+            }
+
+            case OPERATOR_INCREMENT:
+            case OPERATOR_DECREMENT:
+                parser_advance(parser);
+                node = parser_node(parser, NODE_TYPE_UNARY, index, node);
+                parser->ast->op[node] = op;
+                parser->ast->flags[node] |= NODE_FLAG_POSTFIX;
+                break;
+
+            default:
+                return node;
+        }
+    }
+    return node;
+}
+
+/**
+ * @brief 类型转换或复合字面量，当前token是'('
+ */
+static uint32_t parser_cast(struct parse_process* parser)
+{
+    int index = parser_advance(parser);
+    uint32_t type = parser_type_name(parser);
+    parser_expect_symbol(parser, ')');
+
+    uint32_t node = NODE_ID_NONE;
+    if(parser_is_symbol(parser_token(parser), '{')){
+        node = parser_node(parser, NODE_TYPE_COMPOUND_LITERAL, index, parser_initializer(parser));
+        parser->ast->type_id[node] = type;
+        return parser_postfix(parser, node);
+    }
+
+    node = parser_node(parser, NODE_TYPE_CAST, index, parser_unary(parser));
+    parser->ast->type_id[node] = type;
+    return node;
+}
+
+/**
+ * @brief 下标index的'('开始类型转换或复合字面量
+ * 括号中只有一个未知的名字时，后面紧跟操作数才是类型转换，如(size_t)n，否则按括号表达式处理
+ */
+static bool parser_is_cast(struct parse_process* parser, int index)
+{
+    int next = parser_next_index(parser, index);
+    if(parser_starts_type(parser, next)){
+        return true;
+    }
+    if(!parser_is_identifier(parser_token_at(parser, next))){
+        return false;
+    }
+
+    next = parser_next_index(parser, next);
+    if(!parser_is_symbol(parser_token_at(parser, next), ')')){
+        return false;
+    }
+    struct token* token = parser_token_at(parser, parser_next_index(parser, next));
+    return token && (TOKEN_TYPE_IDENTIFIER == token->type || TOKEN_TYPE_NUMBER == token->type ||
+                     TOKEN_TYPE_STRING == token->type || token_is_keyword_id(token, KEYWORD_SIZEOF));
+}
+
+static uint32_t parser_unary(struct parse_process* parser)
+{
+    struct token* token = parser_token(parser);
+    if(!token){
+        parser_error(parser, "Unexpected end of file in an expression\n");
+    }
+
+    int index = parser->index;
+    if(TOKEN_TYPE_OPERATOR == token->type){
+        switch(token->op){
+            case OPERATOR_INCREMENT:
+            case OPERATOR_DECREMENT:
+            case OPERATOR_MINUS:
+            case OPERATOR_PLUS:
+            case OPERATOR_NOT:
+            case OPERATOR_BITWISE_NOT:
+            case OPERATOR_STAR:
+            case OPERATOR_AMPERSAND:
+            // GNU扩展，&&label取标签地址
+            case OPERATOR_LOGICAL_AND: {
+                parser_advance(parser);
+                uint32_t node = parser_node(parser, NODE_TYPE_UNARY, index, parser_unary(parser));
+                parser->ast->op[node] = token->op;
+                return node;
+            }
+
+            case OPERATOR_LPAREN:
+                if(parser_is_cast(parser, index)){
+                    return parser_cast(parser);
+                }
+                break;
+        }
+    }
+    else if(token_is_keyword_id(token, KEYWORD_SIZEOF)){
+        parser_advance(parser);
+        if(parser_is_operator(parser_token(parser), OPERATOR_LPAREN) &&
+           parser_starts_type(parser, parser_next_index(parser, parser->index))){
+            parser_advance(parser);
+            uint32_t type = parser_type_name(parser);
+            parser_expect_symbol(parser, ')');
+            uint32_t node = parser_node(parser, NODE_TYPE_SIZEOF, index, NODE_ID_NONE);
+            parser->ast->type_id[node] = type;
+            return node;
+        }
+        return parser_node(parser, NODE_TYPE_SIZEOF, index, parser_unary(parser));
+    }
+
+    return parser_postfix(parser, parser_primary(parser));
+}
+
+/**
+ * @brief 按优先级循环分析二元运算，只读入优先级不低于min_precedence的运算符
+ * 赋值和三目运算右结合，其余左结合
+ */
+static uint32_t parser_expression(struct parse_process* parser, int min_precedence)
+{
+    uint32_t left = parser_unary(parser);
+    for(struct token* token = parser_token(parser); token && TOKEN_TYPE_OPERATOR == token->type; token = parser_token(parser)){
+        int precedence = parser_precedence[token->op];
+        if(PARSER_PRECEDENCE_NONE == precedence || precedence < min_precedence){
+            break;
+        }
+
+        int index = parser_advance(parser);
+        if(OPERATOR_QUESTION == token->op){
+            // 中间可以是任意表达式，冒号之后仍是三目运算
+            uint32_t then = parser_expression(parser, PARSER_PRECEDENCE_COMMA);
+            parser_expect_symbol(parser, ':');
+            uint32_t otherwise = parser_expression(parser, PARSER_PRECEDENCE_TERNARY);
+            left = parser_node_3(parser, NODE_TYPE_TERNARY, index, left, then, otherwise);
+            parser->ast->op[left] = token->op;
+            continue;
+        }
+
+        int next = PARSER_PRECEDENCE_ASSIGN == precedence ? precedence : precedence + 1;
+        uint32_t right = parser_expression(parser, next);
+        left = parser_node_2(parser, NODE_TYPE_EXPRESSION, index, left, right);
+        parser->ast->op[left] = token->op;
+    }
+    return left;
+}
+
+/*----------func used for parse initializers-----------*/
+/**
+ * @brief 初始化列表的一项，可以带.member、[index]指示符
+ */
+static uint32_t parser_initializer_element(struct parse_process* parser)
+{
+    struct token* token = parser_token(parser);
+    if(!parser_is_operator(token, OPERATOR_DOT) && !parser_is_operator(token, OPERATOR_LBRACKET)){
+        return parser_initializer(parser);
+    }
+
+    int start = parser->index;
+    struct parser_list designators = {};
+    for(;;){
+        int index = parser->index;
+        uint32_t designator = NODE_ID_NONE;
+        if(parser_accept_operator(parser, OPERATOR_DOT)){
+            uint32_t member = parser_node(parser, NODE_TYPE_IDENTIFIER, parser_expect_identifier(parser), NODE_ID_NONE);
+            designator = parser_node(parser, NODE_TYPE_DESIGNATOR, index, member);
+            parser->ast->op[designator] = OPERATOR_DOT;
+        }
+        else if(parser_accept_operator(parser, OPERATOR_LBRACKET)){
+            designator = parser_node(parser, NODE_TYPE_DESIGNATOR, index, parser_expression(parser, PARSER_PRECEDENCE_TERNARY));
+            parser->ast->op[designator] = OPERATOR_LBRACKET;
+            parser_expect_symbol(parser, ']');
+        }
+        else{
+            break;
+        }
+        parser_list_push(parser, &designators, designator);
+    }
+
+    if(!parser_accept_operator(parser, OPERATOR_ASSIGN)){
+        parser_error(parser, "Expecting = after the designator\n");
+    }
+    parser_list_push(parser, &designators, parser_initializer(parser));
+    return parser_node(parser, NODE_TYPE_DESIGNATION, start, designators.first);
+}
+
+static uint32_t parser_initializer(struct parse_process* parser)
+{
+    if(!parser_is_symbol(parser_token(parser), '{')){
+        return parser_expression(parser, PARSER_PRECEDENCE_ASSIGN);
+    }
+
+    int index = parser_advance(parser);
+    struct parser_list elements = {};
+    while(!parser_accept_symbol(parser, '}')){
+        parser_list_push(parser, &elements, parser_initializer_element(parser));
+        if(!parser_accept_operator(parser, OPERATOR_COMMA) && !parser_is_symbol(parser_token(parser), '}')){
+            parser_error(parser, "Expecting , or } in the initializer list\n");
+        }
+    }
+    return parser_node(parser, NODE_TYPE_INITIALIZER_LIST, index, elements.first);
+}
+
+/*----------func used for parse declarations-----------*/
+/**
+ * @brief 一个声明符及其初始值、位域宽度或函数体
+ */
+static uint32_t parser_declarator_node(struct parse_process* parser, uint32_t specifiers, int scope)
+{
+    int start = parser->index;
+    int name = -1;
+    uint32_t type = parser_declarator(parser, specifiers, &name);
+    bool bitfield = PARSER_SCOPE_MEMBER == scope && parser_is_symbol(parser_token(parser), ':');
+    if(name < 0 && !bitfield){
+        parser_error(parser, "Expecting a name in the declaration\n");
+    }
+    bool is_typedef = parser_datatype_at(parser, specifiers)->flags & DATATYPE_FLAG_TYPEDEF;
+    if(is_typedef){
+        parser_add_typedef(parser, parser->tokens[name].sval);
+    }
+
+    int token_index = name >= 0 ? name : start;
+    uint32_t node = NODE_ID_NONE;
+    if(DATATYPE_FUNCTION == parser_datatype_at(parser, type)->type && !is_typedef){
+        uint32_t body = NODE_ID_NONE;
+        if(PARSER_SCOPE_GLOBAL == scope && parser_is_symbol(parser_token(parser), '{')){
+            body = parser_body(parser);
+        }
+        node = parser_node(parser, NODE_TYPE_FUNCTION, token_index, body);
+    }
+    else if(bitfield){
+        parser_advance(parser);
+        node = parser_node(parser, NODE_TYPE_VARIABLE, token_index, parser_expression(parser, PARSER_PRECEDENCE_TERNARY));
+        parser->ast->flags[node] |= NODE_FLAG_BITFIELD;
+    }
+    else if(PARSER_SCOPE_MEMBER != scope && parser_accept_operator(parser, OPERATOR_ASSIGN)){
+        node = parser_node(parser, NODE_TYPE_VARIABLE, token_index, parser_initializer(parser));
+    }
+    else{
+        node = parser_node(parser, NODE_TYPE_VARIABLE, token_index, NODE_ID_NONE);
+    }
+
+    if(name < 0){
+        parser->ast->flags[node] |= NODE_FLAG_ANONYMOUS;
+    }
+    parser->ast->type_id[node] = type;
+    return node;
+}
+
+/**
+ * @brief 声明或函数定义
+ *
+ * @return uint32_t 只有一个声明符时直接返回它，否则返回NODE_TYPE_VARIABLE_LIST
+ */
+static uint32_t parser_declaration(struct parse_process* parser, int scope)
+{
+    // _Static_assert(cond, "msg");按函数调用记录
+    struct token* token = parser_token(parser);
+    if(parser_is_identifier(token) && token->sval == parser->static_assert_word){
+        return parser_expression_statement(parser);
+    }
+
+    int start = parser->index;
+    uint32_t specifiers = parser_specifiers(parser, false);
+    if(!specifiers){
+        // 省略类型的旧式全局声明，如main()
+        if(PARSER_SCOPE_GLOBAL != scope || !parser_is_identifier(parser_token(parser))){
+            parser_error(parser, "Expecting a declaration\n");
+        }
+        specifiers = parser_datatype(parser, DATATYPE_INT, DATATYPE_ID_NONE);
+    }
+
+    struct parser_list declarators = {};
+    if(!parser_is_symbol(parser_token(parser), ';')){
+        do{
+            uint32_t node = parser_declarator_node(parser, specifiers, scope);
+            // 函数定义之后没有';'
+            if(NODE_TYPE_FUNCTION == parser->ast->kind[node] && parser->ast->first_child[node] != NODE_ID_NONE){
+                if(declarators.first != NODE_ID_NONE){
+                    parser_error(parser, "A function body cannot follow other declarators\n");
+                }
+                return node;
+            }
+            parser_list_push(parser, &declarators, node);
+        } while(parser_accept_operator(parser, OPERATOR_COMMA));
+    }
+    parser_expect_symbol(parser, ';');
+
+    if(declarators.first != NODE_ID_NONE && declarators.first == declarators.last){
+        return declarators.first;
+    }
+    uint32_t list = parser_node(parser, NODE_TYPE_VARIABLE_LIST, start, declarators.first);
+    parser->ast->type_id[list] = specifiers;
+    return list;
+}
+
+/*----------func used for parse statements-----------*/
+static uint32_t parser_statement(struct parse_process* parser);
+
+static uint32_t parser_body(struct parse_process* parser)
+{
+    int index = parser_expect_symbol(parser, '{');
+    struct parser_list statements = {};
+    while(!parser_accept_symbol(parser, '}')){
+        if(!parser_token(parser)){
+            parser_error(parser, "You did not close the body with }\n");
+        }
+        parser_list_push(parser, &statements, parser_statement(parser));
+    }
+    return parser_node(parser, NODE_TYPE_BODY, index, statements.first);
+}
+
+/**
+ * @brief if、while、switch的括号中的条件
+ */
+static uint32_t parser_condition(struct parse_process* parser)
+{
+    if(!parser_accept_operator(parser, OPERATOR_LPAREN)){
+        parser_error(parser, "Expecting ( before the condition\n");
+    }
+    uint32_t node = parser_expression(parser, PARSER_PRECEDENCE_COMMA);
+    parser_expect_symbol(parser, ')');
+    return node;
+}
+
+static uint32_t parser_expression_statement(struct parse_process* parser)
+{
+    uint32_t node = parser_expression(parser, PARSER_PRECEDENCE_COMMA);
+    parser_expect_symbol(parser, ';');
+    return node;
+}
+
+/**
+ * @brief 标签之后的语句，紧跟'}'时视为空语句
+ */
+static uint32_t parser_labeled(struct parse_process* parser)
+{
+    if(parser_is_symbol(parser_token(parser), '}')){
+        return parser_blank(parser);
+    }
+    return parser_statement(parser);
+}
+
+static uint32_t parser_for(struct parse_process* parser)
+{
+    int index = parser_advance(parser);
+    if(!parser_accept_operator(parser, OPERATOR_LPAREN)){
+        parser_error(parser, "Expecting ( after for\n");
+    }
+
+    // 初始化部分可以是声明，声明自己读入';'
+    struct parser_list parts = {};
+    if(parser_is_symbol(parser_token(parser), ';')){
+        parser_list_push(parser, &parts, parser_blank(parser));
+        parser_advance(parser);
+    }
+    else if(parser_starts_type(parser, parser->index)){
+        parser_list_push(parser, &parts, parser_declaration(parser, PARSER_SCOPE_LOCAL));
+    }
+    else{
+        parser_list_push(parser, &parts, parser_expression_statement(parser));
+    }
+
+    if(parser_is_symbol(parser_token(parser), ';')){
+        parser_list_push(parser, &parts, parser_blank(parser));
+    }
+    else{
+        parser_list_push(parser, &parts, parser_expression(parser, PARSER_PRECEDENCE_COMMA));
+    }
+    parser_expect_symbol(parser, ';');
+
+    if(parser_is_symbol(parser_token(parser), ')')){
+        parser_list_push(parser, &parts, parser_blank(parser));
+    }
+    else{
+        parser_list_push(parser, &parts, parser_expression(parser, PARSER_PRECEDENCE_COMMA));
+    }
+    parser_expect_symbol(parser, ')');
+    parser_list_push(parser, &parts, parser_statement(parser));
+    return parser_node(parser, NODE_TYPE_STATEMENT_FOR, index, parts.first);
+}
+
+/**
+ * @brief 以关键字开头的语句
+ *
+ * @return uint32_t 不是语句关键字时返回NODE_ID_NONE，如类型说明、sizeof
+ */
+static uint32_t parser_keyword_statement(struct parse_process* parser, int keyword)
+{
+    int index = parser->index;
+    switch(keyword){
+        case KEYWORD_IF: {
+            parser_advance(parser);
+            uint32_t cond = parser_condition(parser);
+            uint32_t then = parser_statement(parser);
+            if(!token_is_keyword_id(parser_token(parser), KEYWORD_ELSE)){
+                return parser_node_2(parser, NODE_TYPE_STATEMENT_IF, index, cond, then);
+            }
+            parser_advance(parser);
+            uint32_t otherwise = parser_statement(parser);
+            return parser_node_3(parser, NODE_TYPE_STATEMENT_IF, index, cond, then, otherwise);
+        }
+
+        case KEYWORD_WHILE: {
+            parser_advance(parser);
+            uint32_t cond = parser_condition(parser);
+            return parser_node_2(parser, NODE_TYPE_STATEMENT_WHILE, index, cond, parser_statement(parser));
+        }
+
+        case KEYWORD_DO: {
+            parser_advance(parser);
+            uint32_t body = parser_statement(parser);
+            if(!token_is_keyword_id(parser_token(parser), KEYWORD_WHILE)){
+                parser_error(parser, "Expecting while after the do body\n");
+            }
+            parser_advance(parser);
+            uint32_t node = parser_node_2(parser, NODE_TYPE_STATEMENT_DO_WHILE, index, body, parser_condition(parser));
+            parser_expect_symbol(parser, ';');
+            return node;
+        }
+
+        case KEYWORD_FOR:
+            return parser_for(parser);
+
+        case KEYWORD_SWITCH: {
+            parser_advance(parser);
+            uint32_t cond = parser_condition(parser);
+            return parser_node_2(parser, NODE_TYPE_STATEMENT_SWITCH, index, cond, parser_statement(parser));
+        }
+
+        case KEYWORD_CASE: {
+            parser_advance(parser);
+            uint32_t value = parser_expression(parser, PARSER_PRECEDENCE_TERNARY);
+            parser_expect_symbol(parser, ':');
+            return parser_node_2(parser, NODE_TYPE_STATEMENT_CASE, index, value, parser_labeled(parser));
+        }
+
+        case KEYWORD_DEFAULT:
+            parser_advance(parser);
+            parser_expect_symbol(parser, ':');
+            return parser_node(parser, NODE_TYPE_STATEMENT_DEFAULT, index, parser_labeled(parser));
+
+        case KEYWORD_RETURN:
+            parser_advance(parser);
+            if(parser_accept_symbol(parser, ';')){
+                return parser_node(parser, NODE_TYPE_STATEMENT_RETURN, index, NODE_ID_NONE);
+            }
+            return parser_node(parser, NODE_TYPE_STATEMENT_RETURN, index, parser_expression_statement(parser));
+
+        case KEYWORD_BREAK:
+        case KEYWORD_CONTINUE:
+            parser_advance(parser);
+            parser_expect_symbol(parser, ';');
+            return parser_node(parser, KEYWORD_BREAK == keyword ? NODE_TYPE_STATEMENT_BREAK : NODE_TYPE_STATEMENT_CONTINUE, index, NODE_ID_NONE);
+
+        case KEYWORD_GOTO: {
+            parser_advance(parser);
+            int label = parser_expect_identifier(parser);
+            parser_expect_symbol(parser, ';');
+            return parser_node(parser, NODE_TYPE_STATEMENT_GOTO, label, NODE_ID_NONE);
+        }
+    }
+    return NODE_ID_NONE;
+}
+
+static uint32_t parser_statement(struct parse_process* parser)
+{
+    struct token* token = parser_token(parser);
+    if(!token){
+        parser_error(parser, "Unexpected end of file, expecting a statement\n");
+    }
+    if(parser_is_symbol(token, '{')){
+        return parser_body(parser);
+    }
+    if(parser_is_symbol(token, ';')){
+        uint32_t blank = parser_blank(parser);
+        parser_advance(parser);
+        return blank;
+    }
+    if(TOKEN_TYPE_KEYWORD == token->type){
+        uint32_t node = parser_keyword_statement(parser, token->keyword);
+        if(node != NODE_ID_NONE){
+            return node;
+        }
+    }
+
+    // 标识符后跟':'是标签
+    if(TOKEN_TYPE_IDENTIFIER == token->type &&
+       parser_is_symbol(parser_token_at(parser, parser_next_index(parser, parser->index)), ':')){
+        int label = parser_advance(parser);
+        parser_advance(parser);
+        return parser_node(parser, NODE_TYPE_LABEL, label, parser_labeled(parser));
+    }
+    if(parser_starts_type(parser, parser->index)){
+        return parser_declaration(parser, PARSER_SCOPE_LOCAL);
+    }
+    return parser_expression_statement(parser);
+}
+
+/**
+ * @brief 语法分析，出错时报告第一个错误并返回PARSE_GENERAL_ERROR，不退出进程
+ *
+ * @param process
+ * @return int
+ */
+int parse(struct compile_process* process)
+{
+    struct parse_process parser = {
+        .compiler = process,
+        .tokens = vector_data_ptr(process->token_vec),
+        .count = vector_count(process->token_vec),
+        .typedefs = calloc(PARSER_TYPEDEFS_INITIAL_CAPACITY, sizeof(const char*)),
+        .typedef_capacity = PARSER_TYPEDEFS_INITIAL_CAPACITY,
+        .inline_word = intern_lookup(process->interns, "inline", strlen("inline")),
+        .static_assert_word = intern_lookup(process->interns, "_Static_assert", strlen("_Static_assert"))
+    };
+    // 按token数预估节点数，避免分析过程中反复扩容
+    parser.ast = ast_create(parser.count / PARSER_ESTIMATED_TOKENS_PER_NODE);
+    // parser的地址传给了各个分析函数，longjmp之后其成员仍是最新值
+    if(setjmp(parser.error_jump)){
+        ast_free(parser.ast);
+        free(parser.typedefs);
+        return PARSE_GENERAL_ERROR;
+    }
+    parser.index = parser_skip_trivia(&parser, 0);
+
+    struct parser_list declarations = {};
+    while(parser_token(&parser)){
+        // 顶层多余的';'
+        if(parser_accept_symbol(&parser, ';')){
+            continue;
+        }
+        parser_list_push(&parser, &declarations, parser_declaration(&parser, PARSER_SCOPE_GLOBAL));
+    }
+    parser.ast->root = parser_node(&parser, NODE_TYPE_PROGRAM, 0, declarations.first);
+    process->ast = parser.ast;
+
+    free(parser.typedefs);
+    return PARSE_ALL_OK;
+}
@@ -1,6 +1,35 @@
 #include "compiler.h"
+#include "helpers/intern.h"
 
+/**
+ * @brief 关键字token保存了关键字编号，只需比较编号
+ */
 bool token_is_keyword(struct token* token, const char* value)
 {
-    return (token->type == TOKEN_TYPE_KEYWORD) && S_EQ(token->sval, value);
-}
\ No newline at end of file
+    return token_is_keyword_id(token, keyword_lookup(value, strlen(value)));
+}
+
+bool token_is_keyword_id(struct token* token, int keyword)
+{
+    return token && (token->type == TOKEN_TYPE_KEYWORD) && token->keyword == keyword;
+}
+
+/**
+ * @brief 标识符驻留时已计算哈希，保存在字串之前
+ */
+unsigned int token_identifier_hash(struct token* token)
+{
+    return intern_string_hash(token->sval);
+}
+
+/**
+ * @brief 浮点数token的值在dnum中，其余数字token在llnum中
+ */
+bool token_is_floating(struct token* token)
+{
+    if(!token || token->type != TOKEN_TYPE_NUMBER){
+        return false;
+    }
+    int type = token->num_type & ~NUMBER_TYPE_FLAG_UNSIGNED;
+    return type == NUMBER_TYPE_FLOAT || type == NUMBER_TYPE_DOUBLE || type == NUMBER_TYPE_LONG_DOUBLE;
+}
@@ -0,0 +1,284 @@
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include "compiler.h"
+#include "helpers/buffer.h"
+#include "helpers/intern.h"
+#include "helpers/vector.h"
+#include "helpers/xxhash.h"
+
+#define TOKEN_CACHE_ALIGN 8
+// 标识符在字串区中的偏移尚未分配
+#define TOKEN_CACHE_NO_OFFSET UINT32_MAX
+
+static size_t token_cache_align(size_t size, size_t align)
+{
+    return (size + align - 1) & ~(align - 1);
+}
+
+static void token_cache_pad(struct buffer* buffer, size_t align)
+{
+    while(buffer->len % align){
+        buffer_write(buffer, 0x00);
+    }
+}
+
+static void token_cache_path(char* path, size_t size, uint64_t source_hash)
+{
+    snprintf(path, size, "%s/%016llx.tok", TOKEN_CACHE_DIR, (unsigned long long)source_hash);
+}
+
+/**
+ * @brief 缓存只对映射到内存的普通文件生效，内容哈希在载入时算出，存储时复用
+ *
+ * @param compiler
+ * @return true
+ * @return false
+ */
+static bool token_cache_enabled(struct compile_process* compiler)
+{
+    return (compiler->flags & COMPILE_PROCESS_FLAG_TOKEN_CACHE) && compiler->cfile.data;
+}
+
+/**
+ * @brief 需要在缓存中保存字串内容的token类型
+ * 关键字与运算符的字串是静态的，载入时由编号恢复
+ *
+ * @param type
+ * @return true
+ * @return false
+ */
+static bool token_cache_is_string_type(int type)
+{
+    return TOKEN_TYPE_IDENTIFIER == type || TOKEN_TYPE_STRING == type || TOKEN_TYPE_COMMENT == type;
+}
+
+/**
+ * @brief 校验缓存中的字串偏移，损坏或被截断的缓存不能让载入越界读取
+ * 字串区以'\0'结尾，偏移落在字串区内即可保证字串在区内结束；
+ * 标识符还须带有完整且与内容相符的intern_header，token只能引用标识符表中的标识符
+ *
+ * @param header
+ * @param data 映射的缓存文件
+ * @param tokens_at
+ * @param identifiers_at
+ * @param strings_at
+ * @return true 偏移全部有效
+ * @return false
+ */
+static bool token_cache_validate(const struct token_cache_header* header, const char* data,
+                                 size_t tokens_at, size_t identifiers_at, size_t strings_at)
+{
+    const char* strings = data + strings_at;
+    size_t strings_size = header->strings_size;
+    if(strings_size > 0 && 0x00 != strings[strings_size - 1]){
+        return false;
+    }
+
+    // 标识符按intern_header对齐存放，每个对齐位置用一位记录是否为标识符
+    size_t align = sizeof(uint32_t);
+    uint8_t* is_identifier = calloc(strings_size / align / 8 + 1, 1);
+    const uint32_t* identifiers = (const uint32_t*)(data + identifiers_at);
+    bool ok = true;
+    for(uint32_t i = 0; ok && i < header->identifier_count; i++){
+        size_t offset = identifiers[i];
+        ok = offset % align == 0 && offset >= sizeof(struct intern_header) && offset < strings_size;
+        if(ok){
+            const struct intern_header* intern_header = (const struct intern_header*)(strings + offset) - 1;
+            ok = intern_header->len < strings_size - offset && 0x00 == strings[offset + intern_header->len] &&
+                 intern_header->hash == intern_hash(strings + offset, intern_header->len);
+            is_identifier[offset / align / 8] |= 1 << (offset / align % 8);
+        }
+    }
+
+    const struct token* tokens = (const struct token*)(data + tokens_at);
+    for(uint32_t i = 0; ok && i < header->token_count; i++){
+        const struct token* token = &tokens[i];
+        if(!token_cache_is_string_type(token->type) || TOKEN_DUMP_NO_STRING == token->llnum){
+            continue;
+        }
+        ok = token->llnum < strings_size;
+        if(ok && TOKEN_TYPE_IDENTIFIER == token->type){
+            size_t offset = token->llnum;
+            ok = offset % align == 0 && (is_identifier[offset / align / 8] & (1 << (offset / align % 8)));
+        }
+    }
+    free(is_identifier);
+    return ok;
+}
+
+/**
+ * @brief 载入缓存：映射缓存文件，token整体拷入token_vec后把字串偏移换回指针
+ *
+ * @param lex_process
+ * @return true 命中，无需再做词法分析
+ * @return false
+ */
+bool token_cache_load(struct lex_process* lex_process)
+{
+    struct compile_process* compiler = lex_process->compiler;
+    if(!token_cache_enabled(compiler)){
+        return false;
+    }
+
+    // 省略注释和换行时token序列不同，标志作为哈希种子，两种结果分开缓存
+    uint64_t seed = compiler->flags & COMPILE_PROCESS_FLAG_ELIDE_TRIVIA;
+    compiler->token_cache.source_hash = xxh64(compiler->cfile.data, compiler->cfile.size, seed);
+    char path[256];
+    token_cache_path(path, sizeof(path), compiler->token_cache.source_hash);
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+
+    struct stat st;
+    const char* data = MAP_FAILED;
+    if(fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(struct token_cache_header)){
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if(MAP_FAILED == data){
+        return false;
+    }
+
+    // 哈希相同但大小、格式不符或偏移越界时按未命中处理，重新做词法分析
+    const struct token_cache_header* header = (const struct token_cache_header*)data;
+    size_t tokens_at = token_cache_align(sizeof(*header), TOKEN_CACHE_ALIGN);
+    size_t brackets_at = tokens_at + (size_t)header->token_count * sizeof(struct token);
+    size_t identifiers_at = brackets_at + (size_t)header->brackets_count * sizeof(struct token_between_brackets);
+    size_t strings_at = token_cache_align(identifiers_at + (size_t)header->identifier_count * sizeof(uint32_t), TOKEN_CACHE_ALIGN);
+    if(header->magic != TOKEN_CACHE_MAGIC || header->version != TOKEN_CACHE_VERSION ||
+       header->source_hash != compiler->token_cache.source_hash || header->source_size != compiler->cfile.size ||
+       header->token_size != sizeof(struct token) || strings_at + header->strings_size != (size_t)st.st_size ||
+       !token_cache_validate(header, data, tokens_at, identifiers_at, strings_at)){
+        munmap((void*)data, st.st_size);
+        return false;
+    }
+
+    compiler->token_cache.data = data;
+    compiler->token_cache.size = st.st_size;
+    const char* strings = data + strings_at;
+
+    // 标识符本身带有intern_header，驻留表直接引用映射中的字串
+    const uint32_t* identifiers = (const uint32_t*)(data + identifiers_at);
+    for(uint32_t i = 0; i < header->identifier_count; i++){
+        intern_adopt(compiler->interns, strings + identifiers[i]);
+    }
+
+    vector_push_multiple(lex_process->between_brackets_vec, data + brackets_at, header->brackets_count);
+    vector_push_multiple(lex_process->token_vec, data + tokens_at, header->token_count);
+    struct token* tokens = vector_data_ptr(lex_process->token_vec);
+    for(uint32_t i = 0; i < header->token_count; i++){
+        struct token* token = &tokens[i];
+        if(TOKEN_TYPE_KEYWORD == token->type){
+            token->sval = keyword_name(token->keyword);
+        }
+        else if(TOKEN_TYPE_OPERATOR == token->type){
+            token->sval = operator_name(token->op);
+        }
+        else if(token_cache_is_string_type(token->type)){
+            token->sval = TOKEN_DUMP_NO_STRING == token->llnum ? NULL : strings + token->llnum;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 把词法分析结果写入缓存，先写临时文件再改名，多个线程同时写同一缓存也不会读到半个文件
+ *
+ * @param lex_process
+ */
+void token_cache_store(struct lex_process* lex_process)
+{
+    struct compile_process* compiler = lex_process->compiler;
+    if(!token_cache_enabled(compiler)){
+        return;
+    }
+
+    struct vector* token_vec = lex_process->token_vec;
+    struct intern_table* interns = compiler->interns;
+    struct buffer* strings = buffer_create();
+    struct vector* identifiers = vector_create(sizeof(uint32_t));
+    struct vector* tokens = vector_create(sizeof(struct token));
+    vector_reserve(tokens, vector_count(token_vec));
+
+    // 按驻留表的槽位记录每个标识符的偏移，相同标识符只写一次
+    uint32_t* identifier_offsets = malloc(interns->capacity * sizeof(uint32_t));
+    memset(identifier_offsets, 0xff, interns->capacity * sizeof(uint32_t));
+    for(int i = 0; i < vector_count(token_vec); i++){
+        struct token token = *(struct token*)vector_at(token_vec, i);
+        if(TOKEN_TYPE_KEYWORD == token.type || TOKEN_TYPE_OPERATOR == token.type){
+            token.llnum = 0;
+        }
+        else if(token_cache_is_string_type(token.type) && !token.sval){
+            token.llnum = TOKEN_DUMP_NO_STRING;
+        }
+        else if(TOKEN_TYPE_IDENTIFIER == token.type){
+            uint32_t* offset = &identifier_offsets[intern_slot(interns, token.sval)];
+            if(TOKEN_CACHE_NO_OFFSET == *offset){
+                struct intern_header intern_header = {
+                    .hash = intern_string_hash(token.sval),
+                    .len = intern_string_len(token.sval)
+                };
+                token_cache_pad(strings, sizeof(uint32_t));
+                buffer_write_bytes(strings, &intern_header, sizeof(intern_header));
+                *offset = strings->len;
+                buffer_write_bytes(strings, token.sval, intern_header.len + 1);
+                vector_push(identifiers, offset);
+            }
+            token.llnum = *offset;
+        }
+        else if(token_cache_is_string_type(token.type)){
+            uint64_t offset = strings->len;
+            buffer_write_bytes(strings, token.sval, strlen(token.sval) + 1);
+            token.llnum = offset;
+        }
+        vector_push(tokens, &token);
+    }
+    free(identifier_offsets);
+
+    struct token_cache_header header = {
+        .magic = TOKEN_CACHE_MAGIC,
+        .version = TOKEN_CACHE_VERSION,
+        .source_hash = compiler->token_cache.source_hash,
+        .source_size = compiler->cfile.size,
+        .token_size = sizeof(struct token),
+        .token_count = vector_count(tokens),
+        .brackets_count = vector_count(lex_process->between_brackets_vec),
+        .identifier_count = vector_count(identifiers),
+        .strings_size = strings->len
+    };
+    struct buffer* out = buffer_create();
+    buffer_write_bytes(out, &header, sizeof(header));
+    token_cache_pad(out, TOKEN_CACHE_ALIGN);
+    buffer_write_bytes(out, vector_data_ptr(tokens), header.token_count * sizeof(struct token));
+    buffer_write_bytes(out, vector_data_ptr(lex_process->between_brackets_vec), header.brackets_count * sizeof(struct token_between_brackets));
+    buffer_write_bytes(out, vector_data_ptr(identifiers), header.identifier_count * sizeof(uint32_t));
+    token_cache_pad(out, TOKEN_CACHE_ALIGN);
+    buffer_write_bytes(out, buffer_ptr(strings), strings->len);
+
+    char path[256];
+    char tmp_path[256];
+    token_cache_path(path, sizeof(path), header.source_hash);
+    snprintf(tmp_path, sizeof(tmp_path), "%s/XXXXXX", TOKEN_CACHE_DIR);
+    mkdir(TOKEN_CACHE_DIR, 0755);
+    int fd = mkstemp(tmp_path);
+    if(fd >= 0){
+        // mkstemp只给属主读写权限，缓存与源文件一样可被他人读取
+        fchmod(fd, 0644);
+        bool ok = write(fd, buffer_ptr(out), out->len) == (ssize_t)out->len;
+        close(fd);
+        if(!ok || rename(tmp_path, path) != 0){
+            unlink(tmp_path);
+        }
+    }
+
+    buffer_free(out);
+    buffer_free(strings);
+    vector_free(identifiers);
+    vector_free(tokens);
+}